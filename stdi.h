@@ -11,6 +11,12 @@
 #ifndef FLUENT_LIBC_STDI_LIBRARY_H
 #define FLUENT_LIBC_STDI_LIBRARY_H
 
+// Expose pipe2, syscall and the POSIX functions even under strict ISO C
+// (-std=c11). This only works if no system header was included before.
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -20,6 +26,68 @@ extern "C"
 #define STDI_READ_LINE_BUFFER_SIZE 250
 #endif
 
+// Set to 1 to make read_line() and raw_read_line() return exact-size allocations
+#ifndef STDI_READ_LINE_SHRINK_TO_FIT
+#define STDI_READ_LINE_SHRINK_TO_FIT 0
+#endif
+
+// Size of the stdin buffer shared by read_line() and the other stdin functions
+#ifndef STDI_STDIN_BUFFER_SIZE
+#define STDI_STDIN_BUFFER_SIZE 4096
+#endif
+
+#ifndef STDI_STRING_POOL_BLOCK_SIZE
+#define STDI_STRING_POOL_BLOCK_SIZE (1024 * 1024)
+#endif
+
+#ifndef STDI_READER_BUFFER_SIZE
+#define STDI_READER_BUFFER_SIZE 65536
+#endif
+
+#ifndef STDI_OWNED_LINE_INLINE_SIZE
+#define STDI_OWNED_LINE_INLINE_SIZE 48
+#endif
+
+#ifndef STDI_WRITER_BUFFER_SIZE
+#define STDI_WRITER_BUFFER_SIZE 65536
+#endif
+
+#ifndef STDI_PARALLEL_CHUNK_SIZE
+#define STDI_PARALLEL_CHUNK_SIZE (1024 * 1024)
+#endif
+
+#ifndef STDI_PARALLEL_CHUNKS_PER_THREAD
+#define STDI_PARALLEL_CHUNKS_PER_THREAD 2
+#endif
+
+#ifndef STDI_DETECT_BLOCK_SIZE
+#define STDI_DETECT_BLOCK_SIZE 4096
+#endif
+
+#ifndef STDI_JSON_MAX_DEPTH
+#define STDI_JSON_MAX_DEPTH 1024
+#endif
+
+#ifndef STDI_RING_CAPACITY
+#define STDI_RING_CAPACITY (4 * 1024 * 1024)
+#endif
+
+// Environment variable naming a ring descriptor to use instead of stdin
+#ifndef STDI_RING_ENV
+#define STDI_RING_ENV "STDI_RING_FD"
+#endif
+
+#define STDI_RING_MAGIC 0x474E495249445453ULL // "STDIRING"
+#define STDI_RING_HEADER_SIZE 4096
+
+#ifndef STDI_SPAWN_PIPE_SIZE
+#define STDI_SPAWN_PIPE_SIZE (1024 * 1024)
+#endif
+
+#ifndef STDI_SIGNAL_READER_BUFFER_SIZE
+#define STDI_SIGNAL_READER_BUFFER_SIZE 512
+#endif
+
 #ifndef EOF
 #define EOF (-1)
 #endif
@@ -34,15 +102,276 @@ extern "C"
 
 // Guard against Windows incompatibility
 #ifndef _WIN32
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <pthread.h>
+#   include <spawn.h>
+#   include <stdint.h>
 #   include <stdlib.h>
+#   include <string.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
 #   include <sys/syscall.h>
+#   include <sys/types.h>
+#   include <sys/uio.h>
+#   include <sys/wait.h>
+#   include <time.h>
 #   include <unistd.h>
 #endif
 
+// Use SSE2 for scanning when available
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+// Enable USDT probes whenever sys/sdt.h is available, each probe is a single nop
+// until a tracer (perf, bpftrace) attaches to it. Define as 0 to leave them out.
+#ifndef STDI_ENABLE_USDT
+#   if defined(__has_include)
+#       if __has_include(<sys/sdt.h>)
+#           define STDI_ENABLE_USDT 1
+#       endif
+#   endif
+#endif
+
+#ifndef STDI_ENABLE_USDT
+#   define STDI_ENABLE_USDT 0
+#endif
+
+// Probes are published under the `stdi` provider:
+// refill__start(fd, size), refill__end(fd, result), line(length),
+// realloc(old_capacity, new_capacity) and error(fd, errno)
+#if STDI_ENABLE_USDT
+#   include <sys/sdt.h>
+#   define STDI_PROBE1(name, a) DTRACE_PROBE1(stdi, name, a)
+#   define STDI_PROBE2(name, a, b) DTRACE_PROBE2(stdi, name, a, b)
+#else
+#   define STDI_PROBE1(name, a) ((void) 0)
+#   define STDI_PROBE2(name, a, b) ((void) 0)
+#endif
+
+// Opt-in latency histograms, see stdi_histogram_dump
+#ifndef STDI_ENABLE_HISTOGRAMS
+#   define STDI_ENABLE_HISTOGRAMS 0
+#endif
+
+#if STDI_ENABLE_HISTOGRAMS && !defined(_WIN32)
+// Values below STDI_HISTOGRAM_SUB_BUCKETS nanoseconds get a bucket each, larger
+// values are split into STDI_HISTOGRAM_SUB_BUCKETS buckets per power of two
+#define STDI_HISTOGRAM_SUB_BUCKETS 16
+#define STDI_HISTOGRAM_BUCKETS ((64 - 3) * STDI_HISTOGRAM_SUB_BUCKETS)
+
+/**
+ * @brief What a latency histogram measures.
+ */
+typedef enum
+{
+    STDI_HISTOGRAM_READ,    // Time spent blocked in read syscalls, high values mean upstream starvation
+    STDI_HISTOGRAM_LINE,    // Time the caller spends between two lines, high values mean local CPU work
+    STDI_HISTOGRAM_KINDS
+} stdi_histogram_kind_t;
+
+/**
+ * @brief A log-linear (HDR-style) histogram of nanosecond durations.
+ *
+ * Buckets keep about 6% relative precision from 1 ns up to the full
+ * 64-bit range.
+ */
+typedef struct
+{
+    uint64_t counts[STDI_HISTOGRAM_BUCKETS];  // Number of samples per bucket
+} stdi_histogram_t;
+
+/**
+ * @brief The histograms recorded by one thread.
+ *
+ * Only the owning thread writes to a block, so recording needs no locks
+ * or atomic read-modify-write instructions. Blocks are registered in a
+ * lock-free list on first use and never freed, so samples from threads
+ * that already exited still show up in dumps.
+ */
+typedef struct stdi_histogram_thread
+{
+    stdi_histogram_t histograms[STDI_HISTOGRAM_KINDS];  // One histogram per kind
+    uint64_t last_line;                                 // When the last line was handed out, or 0
+    struct stdi_histogram_thread *next;                 // Next registered block
+} stdi_histogram_thread_t;
+
+// Weak definitions are shared by every translation unit including this header
+stdi_histogram_thread_t *stdi_histogram_threads __attribute__((weak)) = NULL;
+__thread stdi_histogram_thread_t *stdi_histogram_local __attribute__((weak)) = NULL;
+
+/**
+ * @brief Maps a duration to its histogram bucket.
+ *
+ * @param value The duration in nanoseconds.
+ * @return The index of the bucket.
+ */
+static inline size_t stdi_histogram_index(const uint64_t value)
+{
+    if (value < STDI_HISTOGRAM_SUB_BUCKETS)
+    {
+        return (size_t) value;
+    }
+
+    // Keep the 4 bits below the most significant one
+    const size_t magnitude = 63 - __builtin_clzll(value);
+    return (magnitude - 3) * STDI_HISTOGRAM_SUB_BUCKETS
+        + (size_t) ((value >> (magnitude - 4)) & (STDI_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/**
+ * @brief Returns the smallest duration that falls into a histogram bucket.
+ *
+ * @param index The index of the bucket.
+ * @return The lower bound of the bucket in nanoseconds.
+ */
+static inline uint64_t stdi_histogram_value(const size_t index)
+{
+    if (index < STDI_HISTOGRAM_SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    const size_t magnitude = index / STDI_HISTOGRAM_SUB_BUCKETS + 3;
+    return (uint64_t) (STDI_HISTOGRAM_SUB_BUCKETS + index % STDI_HISTOGRAM_SUB_BUCKETS) << (magnitude - 4);
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return The current time in nanoseconds.
+ */
+static inline uint64_t stdi_histogram_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * @brief Returns the calling thread's histograms, registering them on first use.
+ *
+ * @return The thread's block, or NULL if it could not be allocated.
+ */
+static inline stdi_histogram_thread_t* stdi_histogram_thread()
+{
+    stdi_histogram_thread_t *block = stdi_histogram_local;
+    if (block != NULL)
+    {
+        return block;
+    }
+
+    block = calloc(1, sizeof(stdi_histogram_thread_t));
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    // Push the block onto the registry
+    block->next = __atomic_load_n(&stdi_histogram_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(
+        &stdi_histogram_threads, &block->next, block, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED
+    ))
+    {
+    }
+
+    stdi_histogram_local = block;
+    return block;
+}
+
+/**
+ * @brief Records a duration in one of the calling thread's histograms.
+ *
+ * @param kind The histogram to record into.
+ * @param duration The duration in nanoseconds.
+ */
+static inline void stdi_histogram_record(const stdi_histogram_kind_t kind, const uint64_t duration)
+{
+    stdi_histogram_thread_t *block = stdi_histogram_thread();
+    if (block == NULL)
+    {
+        return;
+    }
+
+    // Single writer, plain atomic stores keep concurrent dumps tear-free
+    uint64_t *count = &block->histograms[kind].counts[stdi_histogram_index(duration)];
+    __atomic_store_n(count, __atomic_load_n(count, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Records the time the caller spent since the previous line was handed out.
+ */
+static inline void stdi_histogram_line_begin()
+{
+    stdi_histogram_thread_t *block = stdi_histogram_thread();
+    if (block != NULL && block->last_line != 0)
+    {
+        stdi_histogram_record(STDI_HISTOGRAM_LINE, stdi_histogram_now() - block->last_line);
+        block->last_line = 0;
+    }
+}
+
+/**
+ * @brief Remembers when a line was handed out to the caller.
+ */
+static inline void stdi_histogram_line_end()
+{
+    stdi_histogram_thread_t *block = stdi_histogram_thread();
+    if (block != NULL)
+    {
+        block->last_line = stdi_histogram_now();
+    }
+}
+
+#   define STDI_HISTOGRAM_START(variable) const uint64_t variable = stdi_histogram_now()
+#   define STDI_HISTOGRAM_STOP(kind, variable) stdi_histogram_record(kind, stdi_histogram_now() - (variable))
+#   define STDI_HISTOGRAM_LINE_BEGIN() stdi_histogram_line_begin()
+#   define STDI_HISTOGRAM_LINE_END() stdi_histogram_line_end()
+#else
+#   define STDI_HISTOGRAM_START(variable) ((void) 0)
+#   define STDI_HISTOGRAM_STOP(kind, variable) ((void) 0)
+#   define STDI_HISTOGRAM_LINE_BEGIN() ((void) 0)
+#   define STDI_HISTOGRAM_LINE_END() ((void) 0)
+#endif
+
+/**
+ * @brief Outcome of a status-returning line read.
+ */
+typedef enum
+{
+    STDI_STATUS_LINE,       // A complete line, terminated by a newline
+    STDI_STATUS_PARTIAL,    // A final line without a trailing newline, the next read reports EOF
+    STDI_STATUS_EOF,        // End of input, no line was read
+    STDI_STATUS_ERROR       // A read or allocation error, no line was read
+} stdi_status_t;
+
+#ifndef _WIN32
+/**
+ * @brief Bytes read from stdin by read_line() past the end of the returned line.
+ *
+ * Every stdin function hands these out before reading again, and a reader
+ * initialized on STDIN_FILENO takes them over, so lines are never merged or
+ * lost whichever functions are mixed. Like the rest of the stdin functions,
+ * this is not thread-safe.
+ */
+typedef struct
+{
+    char data[STDI_STDIN_BUFFER_SIZE];  // Buffered bytes
+    size_t start;                       // Index of the first unconsumed byte
+    size_t end;                         // Index one past the last buffered byte
+} stdi_stdin_buffer_t;
+
+// Weak so every translation unit shares the same buffered bytes
+stdi_stdin_buffer_t stdi_stdin_buffer __attribute__((weak));
+#endif
+
 /**
  * @brief Reads a specified number of bytes from standard input (stdin) into a buffer.
  *
  * This function uses a low-level system call to read data from the standard input.
+ * Bytes that read_line() already buffered are returned first, without a syscall.
  *
  * @param buffer A pointer to the buffer where the read data will be stored.
  * @param size The maximum number of bytes to read.
@@ -52,7 +381,28 @@ static inline ssize_t fread_line(char* buffer, const size_t size)
 {
     // Guard against Windows incompatibility
 #   ifndef _WIN32
-    return syscall(SYS_read, STDIN_FILENO, buffer, size);
+    // Hand out the bytes buffered by read_line() first
+    const size_t buffered = stdi_stdin_buffer.end - stdi_stdin_buffer.start;
+    if (buffered > 0)
+    {
+        const size_t count = buffered < size ? buffered : size;
+        memcpy(buffer, stdi_stdin_buffer.data + stdi_stdin_buffer.start, count);
+        stdi_stdin_buffer.start += count;
+        return (ssize_t) count;
+    }
+
+    STDI_PROBE2(refill__start, STDIN_FILENO, size);
+    STDI_HISTOGRAM_START(started);
+    const ssize_t bytes_read = syscall(SYS_read, STDIN_FILENO, buffer, size);
+    STDI_HISTOGRAM_STOP(STDI_HISTOGRAM_READ, started);
+    STDI_PROBE2(refill__end, STDIN_FILENO, bytes_read);
+
+    if (bytes_read == -1)
+    {
+        STDI_PROBE2(error, STDIN_FILENO, errno);
+    }
+
+    return bytes_read;
 #   else
     return -1;
 #   endif
@@ -65,30 +415,39 @@ static inline ssize_t fread_line(char* buffer, const size_t size)
  * one by one until a newline or EOF is encountered. If the buffer size is exceeded, it
  * reallocates memory to accommodate additional characters.
  *
+ * The newline is not included in the returned string. Since the length is reported
+ * explicitly, embedded NUL bytes are preserved and no strlen pass is needed.
+ *
  * @note This function is marked as deprecated due to its computational expense and reliance
  *       on low-level system calls. Use with caution.
  *
- * @return A pointer to the dynamically allocated string containing the input line, or NULL
- *         if an error occurs (e.g., memory allocation failure or read error).
+ * @param line Receives the dynamically allocated line, or NULL on EOF and errors.
+ * @param length Receives the length of the line in bytes, may be NULL.
+ * @return Whether a complete line, a final partial line, EOF or an error was encountered.
  *
  * @warning The caller is responsible for freeing the memory allocated for the returned string.
  */
 // @deprecated - Computationally expensive, use at your own risk.
-static inline char* raw_read_line()
+static inline stdi_status_t raw_read_line_status(char **line, size_t *length)
 {
+    *line = NULL;
+
     // Guard against Windows incompatibility
 #   ifndef _WIN32
+    STDI_HISTOGRAM_LINE_BEGIN();
+
     // Allocate the string (+1 for the null terminator)
     char *buffer = malloc(sizeof(char) * (STDI_READ_LINE_BUFFER_SIZE + 1));
 
     // Check for allocation failure
     if (buffer == NULL)
     {
-        return NULL;
+        return STDI_STATUS_ERROR;
     }
 
     size_t written = 0;
-    size_t length = 0;
+    size_t total = 0;
+    stdi_status_t status = STDI_STATUS_LINE;
 
     // Keep reading until we find a newline or EOF
     while (TRUE)
@@ -97,11 +456,13 @@ static inline char* raw_read_line()
         if (written == STDI_READ_LINE_BUFFER_SIZE)
         {
             // Reallocate immediately (+1 for the null terminator)
-            char *new_buffer = realloc(buffer, sizeof(char) * (STDI_READ_LINE_BUFFER_SIZE + length + 1));
+            STDI_PROBE2(realloc, total, STDI_READ_LINE_BUFFER_SIZE + total);
+            char *new_buffer = realloc(buffer, sizeof(char) * (STDI_READ_LINE_BUFFER_SIZE + total + 1));
             if (new_buffer == NULL)
             {
+                STDI_PROBE2(error, STDIN_FILENO, ENOMEM);
                 free(buffer);
-                return NULL;
+                return STDI_STATUS_ERROR;
             }
 
             // Reassign the buffer
@@ -117,30 +478,108 @@ static inline char* raw_read_line()
         if (bytes_read == -1)
         {
             free(buffer);
-            return NULL;
+            return STDI_STATUS_ERROR;
+        }
+
+        // Stop at the end of input, keeping a final line without a newline
+        if (bytes_read == 0)
+        {
+            if (total == 0)
+            {
+                free(buffer);
+                if (length != NULL)
+                {
+                    *length = 0;
+                }
+
+                return STDI_STATUS_EOF;
+            }
+
+            buffer[total] = '\0';
+            status = STDI_STATUS_PARTIAL;
+            break;
         }
 
-        // Stop if we find a newline or EOF
-        if (c == '\0' || c == EOF)
+        // Stop if we find a newline
+        if (c == '\n')
         {
             // Add a null terminator
-            buffer[length] = '\0';
+            buffer[total] = '\0';
             break;
         }
 
         // Write the character
-        buffer[length] = c;
+        buffer[total] = c;
 
         written++;
-        length++;
+        total++;
+    }
+
+    // Report the length
+    STDI_PROBE1(line, total);
+    if (length != NULL)
+    {
+        *length = total;
     }
 
-    return buffer;
+#   if STDI_READ_LINE_SHRINK_TO_FIT
+    // Give back the unused space (+1 for the null terminator)
+    char *exact = realloc(buffer, sizeof(char) * (total + 1));
+    if (exact != NULL)
+    {
+        buffer = exact;
+    }
+#   endif
+
+    STDI_HISTOGRAM_LINE_END();
+    *line = buffer;
+    return status;
 #   else
-    return NULL;
+    (void) length;
+    return STDI_STATUS_ERROR;
 #   endif
 }
 
+/**
+ * @brief Reads a line of input from standard input (stdin) using a low-level system call.
+ *
+ * Same as `raw_read_line_status`, except that the end of input yields an
+ * empty string, just like a blank line would.
+ *
+ * @param length Receives the length of the line in bytes, may be NULL.
+ * @return A pointer to the dynamically allocated string containing the input line, or NULL
+ *         if an error occurs (e.g., memory allocation failure or read error).
+ *
+ * @warning The caller is responsible for freeing the memory allocated for the returned string.
+ */
+// @deprecated - Computationally expensive, use at your own risk.
+static inline char* raw_read_line_with_length(size_t *length)
+{
+    char *line;
+    if (raw_read_line_status(&line, length) == STDI_STATUS_EOF)
+    {
+        line = calloc(1, sizeof(char));
+    }
+
+    return line;
+}
+
+/**
+ * @brief Reads a line of input from standard input (stdin) using a low-level system call.
+ *
+ * Same as `raw_read_line_with_length`, without reporting the length.
+ *
+ * @return A pointer to the dynamically allocated string containing the input line, or NULL
+ *         if an error occurs (e.g., memory allocation failure or read error).
+ *
+ * @warning The caller is responsible for freeing the memory allocated for the returned string.
+ */
+// @deprecated - Computationally expensive, use at your own risk.
+static inline char* raw_read_line()
+{
+    return raw_read_line_with_length(NULL);
+}
+
 /**
  * @brief Reads a line of input from standard input (stdin) using a low-level system call.
  *
@@ -148,18 +587,37 @@ static inline char* raw_read_line()
  * until a newline or EOF is encountered. If the buffer size is exceeded, it reallocates
  * memory to accommodate additional characters.
  *
- * @note This function is similar to `raw_read_line` but uses a more efficient approach
- *       for reading chunks of data instead of single characters.
+ * Only the bytes up to the first '\n' are returned, even when a read delivered several
+ * lines at once. The bytes after it stay in a process-wide stdin buffer of up to
+ * STDI_STDIN_BUFFER_SIZE bytes and are returned by the next call (or by fread_line(),
+ * read_char() and raw_read_line()), and a stdi_reader_t initialized on STDIN_FILENO
+ * takes them over.
  *
- * @return A pointer to the dynamically allocated string containing the input line, or NULL
- *         if an error occurs (e.g., memory allocation failure or read error).
+ * @warning Those buffered bytes have already been read from the descriptor, so anything
+ *          else reading fd 0 (stdio, read(2), exec'd children) does not see them. Use
+ *          raw_read_line_status() where stdin is shared that way, it never reads past
+ *          the newline.
+ *
+ * The newline is not included in the returned string. Since the length is reported
+ * explicitly, embedded NUL bytes are preserved and no strlen pass is needed.
+ *
+ * @note This function is similar to `raw_read_line_with_length` but uses a more efficient
+ *       approach for reading chunks of data instead of single characters.
+ *
+ * @param line Receives the dynamically allocated line, or NULL on EOF and errors.
+ * @param length Receives the length of the line in bytes, may be NULL.
+ * @return Whether a complete line, a final partial line, EOF or an error was encountered.
  *
  * @warning The caller is responsible for freeing the memory allocated for the returned string.
  */
-static inline char* read_line()
+static inline stdi_status_t read_line_status(char **line, size_t *length)
 {
+    *line = NULL;
+
     // Guard against Windows incompatibility
 #   ifndef _WIN32
+    STDI_HISTOGRAM_LINE_BEGIN();
+
     // Advice: call fflush(stdout) before calling read_line()
     // Or flush_write_buffer() from stdo which is compatible with
     // fluentlibc
@@ -170,87 +628,172 @@ static inline char* read_line()
     // Check for allocation failure
     if (buffer == NULL)
     {
-        return NULL;
+        return STDI_STATUS_ERROR;
     }
 
     // Initialize tracking variables
-    size_t written = 0;
-    size_t length = 0;
+    size_t capacity = STDI_READ_LINE_BUFFER_SIZE;
+    size_t total = 0;
+    stdi_status_t status = STDI_STATUS_LINE;
+    stdi_stdin_buffer_t *input = &stdi_stdin_buffer;
 
-    // Read until we find EOF
+    // Read until we find a newline or EOF
     while (TRUE)
     {
+        // Take the buffered bytes up to the first newline
+        const size_t available = input->end - input->start;
+        const char *newline = memchr(input->data + input->start, '\n', available);
+        const size_t take = newline == NULL ? available : (size_t) (newline - (input->data + input->start));
+
         // Check if we have to reallocate the buffer
-        if (written == STDI_READ_LINE_BUFFER_SIZE)
+        if (total + take > capacity)
         {
+            size_t new_capacity = capacity;
+            while (new_capacity < total + take)
+            {
+                new_capacity += STDI_READ_LINE_BUFFER_SIZE;
+            }
+
             // Reallocate immediately (+1 for null terminator)
-            char *new_buffer = realloc(buffer, sizeof(char) * (STDI_READ_LINE_BUFFER_SIZE + length + 1));
+            STDI_PROBE2(realloc, capacity, new_capacity);
+            char *new_buffer = realloc(buffer, sizeof(char) * (new_capacity + 1));
             // Check for realloc errors
             if (new_buffer == NULL)
             {
+                STDI_PROBE2(error, STDIN_FILENO, ENOMEM);
                 free(buffer);
-                return NULL;
+                return STDI_STATUS_ERROR;
             }
 
-            written = 0;
+            capacity = new_capacity;
             buffer = new_buffer;
         }
 
-        // Check if we have to read
-        if (written == 0)
+        memcpy(buffer + total, input->data + input->start, take);
+        total += take;
+        input->start += take;
+
+        // Stop at the newline, leaving the bytes after it buffered
+        if (newline != NULL)
         {
-            // Increment the counter
-            const ssize_t bytes_read = fread_line(
-                buffer + length,
-                STDI_READ_LINE_BUFFER_SIZE - length
-             );
+            input->start++;
+            break;
+        }
 
-            // Handle errors
-            if (bytes_read == -1)
+        // Refill the shared buffer
+        const ssize_t bytes_read = fread_line(input->data, sizeof(input->data));
+        input->start = 0;
+        input->end = bytes_read > 0 ? (size_t) bytes_read : 0;
+
+        // Handle errors
+        if (bytes_read == -1)
+        {
+            free(buffer);
+            return STDI_STATUS_ERROR;
+        }
+
+        // Check if no bytes were read, keeping a final line without a newline
+        if (bytes_read == 0)
+        {
+            if (total == 0)
             {
                 free(buffer);
-                return NULL;
-            }
+                if (length != NULL)
+                {
+                    *length = 0;
+                }
 
-            // Check if no bytes were read
-            if (bytes_read == 0)
-            {
-                // Add a null terminator
-                buffer[length] = '\0';
-                return buffer;
+                return STDI_STATUS_EOF;
             }
 
-            written += bytes_read;
-            length += bytes_read;
+            status = STDI_STATUS_PARTIAL;
+            break;
         }
+    }
 
-        // Check if we have an EOF or newline
-        if (length > 0 && (buffer[length - 1] == EOF || buffer[length - 1] == '\n'))
-        {
-            // Add a null terminator
-            buffer[length - 1] = '\0';
-            return buffer;
-        }
+    // Add a null terminator
+    buffer[total] = '\0';
+
+    // Report the length
+    STDI_PROBE1(line, total);
+    if (length != NULL)
+    {
+        *length = total;
     }
+
+#   if STDI_READ_LINE_SHRINK_TO_FIT
+    // Give back the unused space (+1 for the null terminator)
+    char *exact = realloc(buffer, sizeof(char) * (total + 1));
+    if (exact != NULL)
+    {
+        buffer = exact;
+    }
+#   endif
+
+    STDI_HISTOGRAM_LINE_END();
+    *line = buffer;
+    return status;
 #   else
-    return NULL;
+    (void) length;
+    return STDI_STATUS_ERROR;
 #   endif
 }
 
 /**
- * @brief Reads a single character from standard input (stdin).
+ * @brief Reads a line of input from standard input (stdin) using a low-level system call.
  *
- * This function uses a low-level system call to read one byte from stdin.
+ * Same as `read_line_status`, except that the end of input yields an
+ * empty string, just like a blank line would.
  *
- * @return The character read from stdin, or '\0' if an error occurs.
+ * @param length Receives the length of the line in bytes, may be NULL.
+ * @return A pointer to the dynamically allocated string containing the input line, or NULL
+ *         if an error occurs (e.g., memory allocation failure or read error).
+ *
+ * @warning The caller is responsible for freeing the memory allocated for the returned string.
  */
-static inline char read_char()
+static inline char* read_line_with_length(size_t *length)
 {
-    // Guard against Windows incompatibility
-#   ifndef _WIN32
-    char c;
-    const ssize_t bytes_read = fread_line(&c, 1);
-    // Handle errors
+    char *line;
+    if (read_line_status(&line, length) == STDI_STATUS_EOF)
+    {
+        line = calloc(1, sizeof(char));
+    }
+
+    return line;
+}
+
+/**
+ * @brief Reads a line of input from standard input (stdin) using a low-level system call.
+ *
+ * Same as `read_line_with_length`, without reporting the length.
+ *
+ * @return A pointer to the dynamically allocated string containing the input line, or NULL
+ *         if an error occurs (e.g., memory allocation failure or read error).
+ *
+ * @note Input past the returned line may be held in a process-wide buffer that only the
+ *       stdin functions of this library see, see `read_line_status`.
+ *
+ * @warning The caller is responsible for freeing the memory allocated for the returned string.
+ */
+static inline char* read_line()
+{
+    return read_line_with_length(NULL);
+}
+
+/**
+ * @brief Reads a single character from standard input (stdin).
+ *
+ * This function uses a low-level system call to read one byte from stdin.
+ *
+ * @return The character read from stdin, or '\0' if an error occurs.
+ */
+static inline char read_char()
+{
+    // Guard against Windows incompatibility
+#   ifndef _WIN32
+    char c;
+    const ssize_t bytes_read = fread_line(&c, 1);
+    // Handle errors
     if (bytes_read == 1)
     {
         return c;
@@ -262,6 +805,5414 @@ static inline char read_char()
 #   endif
 }
 
+// Guard against Windows incompatibility
+#ifndef _WIN32
+
+/**
+ * @brief When a writer tied to a reader flushes its pending output.
+ */
+typedef enum
+{
+    STDI_FLUSH_EXPLICIT,    // Only flush when asked to or when the buffer is full
+    STDI_FLUSH_BEFORE_READ  // Also flush before a tied reader would block
+} stdi_flush_policy_t;
+
+/**
+ * @brief A buffered writer over a file descriptor.
+ *
+ * Output is collected in a large buffer and written with as few syscalls
+ * as possible. Payloads that do not fit are written together with the
+ * pending bytes in a single writev call.
+ *
+ * A writer over fd -1 keeps all output in memory and grows its buffer
+ * instead of flushing.
+ */
+typedef struct
+{
+    int fd;                         // Destination file descriptor
+    char *buffer;                   // Heap-allocated output buffer
+    size_t capacity;                // Size of the buffer in bytes
+    size_t length;                  // Number of pending bytes
+    stdi_flush_policy_t policy;     // When a tied reader flushes this writer
+    bool error;                     // Whether a write failed
+} stdi_writer_t;
+
+/**
+ * @brief Writes every byte described by an iovec array, retrying on partial writes and EINTR.
+ *
+ * The iovec array is modified in place.
+ *
+ * @param fd The file descriptor to write to.
+ * @param vectors The iovec array describing the data.
+ * @param count The number of entries in `vectors`.
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_fd_writev_all(const int fd, struct iovec *vectors, int count)
+{
+    while (count > 0)
+    {
+        const ssize_t bytes_written = syscall(SYS_writev, fd, vectors, count);
+
+        // Retry if we got interrupted by a signal
+        if (bytes_written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return FALSE;
+        }
+
+        // Skip the vectors that were written completely
+        size_t remaining = (size_t) bytes_written;
+        while (count > 0 && remaining >= vectors->iov_len)
+        {
+            remaining -= vectors->iov_len;
+            vectors++;
+            count--;
+        }
+
+        // Advance into a partially written vector
+        if (count > 0)
+        {
+            vectors->iov_base = (char *) vectors->iov_base + remaining;
+            vectors->iov_len -= remaining;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Initializes a buffered writer over a file descriptor.
+ *
+ * @param writer The writer to initialize.
+ * @param fd The file descriptor to write to (e.g. STDOUT_FILENO).
+ * @param capacity The buffer size, or 0 to use STDI_WRITER_BUFFER_SIZE.
+ * @param policy When a tied reader flushes this writer.
+ * @return TRUE on success, FALSE if the buffer could not be allocated.
+ */
+static inline bool stdi_writer_init(
+    stdi_writer_t *writer,
+    const int fd,
+    size_t capacity,
+    const stdi_flush_policy_t policy
+)
+{
+    // Fall back to the default buffer size
+    if (capacity == 0)
+    {
+        capacity = STDI_WRITER_BUFFER_SIZE;
+    }
+
+    // Allocate the buffer
+    writer->buffer = malloc(sizeof(char) * capacity);
+    if (writer->buffer == NULL)
+    {
+        return FALSE;
+    }
+
+    writer->fd = fd;
+    writer->capacity = capacity;
+    writer->length = 0;
+    writer->policy = policy;
+    writer->error = FALSE;
+    return TRUE;
+}
+
+/**
+ * @brief Writes all pending output.
+ *
+ * @param writer The writer to flush.
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_writer_flush(stdi_writer_t *writer)
+{
+    // Memory writers keep their output
+    if (writer->length == 0 || writer->fd < 0)
+    {
+        return TRUE;
+    }
+
+    struct iovec vector = { writer->buffer, writer->length };
+    writer->length = 0;
+
+    if (!stdi_fd_writev_all(writer->fd, &vector, 1))
+    {
+        writer->error = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Flushes pending output and releases the memory held by a writer.
+ *
+ * The underlying file descriptor is not closed.
+ *
+ * @param writer The writer to destroy.
+ * @return TRUE if the final flush succeeded, FALSE otherwise.
+ */
+static inline bool stdi_writer_destroy(stdi_writer_t *writer)
+{
+    const bool flushed = stdi_writer_flush(writer);
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->capacity = 0;
+    return flushed;
+}
+
+/**
+ * @brief Appends up to two payloads to a writer, coalescing them with the pending output.
+ *
+ * @param writer The writer to append to.
+ * @param data The first payload.
+ * @param size The size of the first payload.
+ * @param suffix The second payload, may be NULL.
+ * @param suffix_size The size of the second payload.
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_writer_append(
+    stdi_writer_t *writer,
+    const char *data,
+    const size_t size,
+    const char *suffix,
+    const size_t suffix_size
+)
+{
+    // Copy into the buffer if everything fits
+    if (writer->length + size + suffix_size <= writer->capacity)
+    {
+        memcpy(writer->buffer + writer->length, data, size);
+        writer->length += size;
+
+        if (suffix_size > 0)
+        {
+            memcpy(writer->buffer + writer->length, suffix, suffix_size);
+            writer->length += suffix_size;
+        }
+
+        return TRUE;
+    }
+
+    // Memory writers grow instead of flushing
+    if (writer->fd < 0)
+    {
+        size_t new_capacity = writer->capacity * 2;
+        while (new_capacity < writer->length + size + suffix_size)
+        {
+            new_capacity *= 2;
+        }
+
+        char *new_buffer = realloc(writer->buffer, sizeof(char) * new_capacity);
+        if (new_buffer == NULL)
+        {
+            writer->error = TRUE;
+            return FALSE;
+        }
+
+        writer->buffer = new_buffer;
+        writer->capacity = new_capacity;
+        return stdi_writer_append(writer, data, size, suffix, suffix_size);
+    }
+
+    // Small payloads go into the buffer after a flush
+    if (size + suffix_size < writer->capacity / 2)
+    {
+        return stdi_writer_flush(writer)
+            && stdi_writer_append(writer, data, size, suffix, suffix_size);
+    }
+
+    // Large payloads are written together with the pending output in one call
+    struct iovec vectors[3] = {
+        { writer->buffer, writer->length },
+        { (void *) data, size },
+        { (void *) suffix, suffix_size }
+    };
+
+    writer->length = 0;
+    if (!stdi_fd_writev_all(writer->fd, vectors, suffix_size > 0 ? 3 : 2))
+    {
+        writer->error = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Writes data through a buffered writer.
+ *
+ * @param writer The writer to write to.
+ * @param data The data to write.
+ * @param size The number of bytes to write.
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_writer_write(stdi_writer_t *writer, const char *data, const size_t size)
+{
+    return stdi_writer_append(writer, data, size, NULL, 0);
+}
+
+/**
+ * @brief Writes data followed by a newline through a buffered writer.
+ *
+ * @param writer The writer to write to.
+ * @param data The line to write, without its newline.
+ * @param size The number of bytes in the line.
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_writer_write_line(stdi_writer_t *writer, const char *data, const size_t size)
+{
+    return stdi_writer_append(writer, data, size, "\n", 1);
+}
+
+/**
+ * @brief Header of a shared-memory ring, followed by its data area.
+ *
+ * The ring lives in a sealed memfd shared by exactly one producer and one
+ * consumer process. The producer only advances `head` and the consumer
+ * only advances `tail`; both are free-running byte counters kept on their
+ * own cache lines. A side only sleeps on a futex after announcing it in its
+ * `*_waiting` word, so wakeup syscalls are skipped while both sides keep up.
+ */
+typedef struct
+{
+    uint64_t magic;             // STDI_RING_MAGIC once the ring is initialized
+    uint64_t capacity;          // Size of the data area, a power of two
+    uint32_t closed;            // Set by the producer once it is done writing
+    uint32_t abandoned;         // Set by the consumer once it stops reading
+    uint64_t head __attribute__((aligned(64)));     // Bytes written so far
+    uint32_t head_sequence;     // Futex word bumped when `head` moves while the consumer waits
+    uint32_t consumer_waiting;  // Whether the consumer is about to sleep
+    uint64_t tail __attribute__((aligned(64)));     // Bytes read so far
+    uint32_t tail_sequence;     // Futex word bumped when `tail` moves while the producer waits
+    uint32_t producer_waiting;  // Whether the producer is about to sleep
+} stdi_ring_t;
+
+/**
+ * @brief Sleeps until a shared futex word changes.
+ *
+ * @param word The futex word.
+ * @param expected The value the word had when the caller decided to sleep.
+ */
+static inline void stdi_futex_wait(uint32_t *word, const uint32_t expected)
+{
+#   if defined(__linux__)
+    // Spurious wakeups and EINTR are fine, callers recheck their condition
+    syscall(SYS_futex, word, 0 /* FUTEX_WAIT */, expected, NULL, NULL, 0);
+#   else
+    (void) word;
+    (void) expected;
+#   endif
+}
+
+/**
+ * @brief Bumps a shared futex word and wakes its sleeper.
+ *
+ * @param word The futex word.
+ */
+static inline void stdi_futex_wake(uint32_t *word)
+{
+    __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+#   if defined(__linux__)
+    syscall(SYS_futex, word, 1 /* FUTEX_WAKE */, 1, NULL, NULL, 0);
+#   endif
+}
+
+/**
+ * @brief Creates a shared-memory ring for a child process to read from.
+ *
+ * The returned descriptor is meant to become the child's standard input
+ * (or be named by the STDI_RING_ENV environment variable), readers
+ * initialized over it then consume the ring instead of the descriptor.
+ * The descriptor is created without close-on-exec.
+ *
+ * @param capacity The size of the data area, rounded up to a power of two,
+ *                 or 0 to use STDI_RING_CAPACITY.
+ * @param fd Receives the memfd backing the ring.
+ * @return The producer's mapping of the ring, or NULL if an error occurs.
+ */
+static inline stdi_ring_t* stdi_ring_create(size_t capacity, int *fd)
+{
+#   if defined(__linux__)
+    // Round the capacity up to a power of two
+    size_t rounded = 4096;
+    while (rounded < (capacity == 0 ? STDI_RING_CAPACITY : capacity))
+    {
+        rounded *= 2;
+    }
+
+    const int memfd = (int) syscall(SYS_memfd_create, "stdi-ring", 2 /* MFD_ALLOW_SEALING */);
+    if (memfd == -1)
+    {
+        return NULL;
+    }
+
+    // Size the file and forbid resizing it, so the consumer can map it safely
+    const size_t size = STDI_RING_HEADER_SIZE + rounded;
+    if (ftruncate(memfd, (off_t) size) == -1
+        || fcntl(memfd, 1033 /* F_ADD_SEALS */, 2 | 4 /* F_SEAL_SHRINK | F_SEAL_GROW */) == -1)
+    {
+        close(memfd);
+        return NULL;
+    }
+
+    stdi_ring_t *ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (ring == MAP_FAILED)
+    {
+        close(memfd);
+        return NULL;
+    }
+
+    // The file starts zeroed, so only the identity needs to be written
+    ring->capacity = rounded;
+    __atomic_store_n(&ring->magic, STDI_RING_MAGIC, __ATOMIC_RELEASE);
+
+    *fd = memfd;
+    return ring;
+#   else
+    (void) capacity;
+    (void) fd;
+    return NULL;
+#   endif
+}
+
+/**
+ * @brief Maps the shared-memory ring behind a file descriptor, if there is one.
+ *
+ * Only sealed memfds whose header carries STDI_RING_MAGIC are accepted,
+ * any other descriptor yields NULL without side effects.
+ *
+ * @param fd The file descriptor to inspect.
+ * @return The consumer's mapping of the ring, or NULL if the descriptor is not a ring.
+ */
+static inline stdi_ring_t* stdi_ring_open(const int fd)
+{
+#   if defined(__linux__)
+    // Only sealed memfds cannot be truncated under our mapping
+    const int seals = fcntl(fd, 1034 /* F_GET_SEALS */);
+    struct stat info;
+    if (seals == -1 || (seals & (2 | 4)) != (2 | 4) || fstat(fd, &info) == -1
+        || info.st_size <= STDI_RING_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    stdi_ring_t *ring = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    // Check the identity of the ring
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != STDI_RING_MAGIC
+        || STDI_RING_HEADER_SIZE + ring->capacity != (uint64_t) info.st_size
+        || (ring->capacity & (ring->capacity - 1)) != 0)
+    {
+        munmap(ring, info.st_size);
+        return NULL;
+    }
+
+    return ring;
+#   else
+    (void) fd;
+    return NULL;
+#   endif
+}
+
+/**
+ * @brief Unmaps a shared-memory ring.
+ *
+ * @param ring The ring to unmap.
+ */
+static inline void stdi_ring_unmap(stdi_ring_t *ring)
+{
+    munmap(ring, STDI_RING_HEADER_SIZE + ring->capacity);
+}
+
+/**
+ * @brief Returns the number of bytes waiting to be read from a ring.
+ *
+ * @param ring The ring to inspect.
+ * @return The number of unread bytes.
+ */
+static inline size_t stdi_ring_available(stdi_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Writes data into a ring, blocking while it is full.
+ *
+ * Must only be called by the producer.
+ *
+ * @param ring The ring to write to.
+ * @param data The data to write.
+ * @param size The number of bytes to write.
+ * @return TRUE on success, FALSE if the consumer abandoned the ring.
+ */
+static inline bool stdi_ring_write(stdi_ring_t *ring, const char *data, size_t size)
+{
+    char *area = (char *) ring + STDI_RING_HEADER_SIZE;
+    const uint64_t mask = ring->capacity - 1;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+    while (size > 0)
+    {
+        const uint64_t room = ring->capacity - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+        if (room == 0)
+        {
+            if (__atomic_load_n(&ring->abandoned, __ATOMIC_ACQUIRE))
+            {
+                return FALSE;
+            }
+
+            // Announce the sleep, then recheck to not miss a wakeup
+            const uint32_t sequence = __atomic_load_n(&ring->tail_sequence, __ATOMIC_ACQUIRE);
+            __atomic_store_n(&ring->producer_waiting, 1, __ATOMIC_SEQ_CST);
+            if (head - __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == ring->capacity
+                && !__atomic_load_n(&ring->abandoned, __ATOMIC_SEQ_CST))
+            {
+                stdi_futex_wait(&ring->tail_sequence, sequence);
+            }
+
+            __atomic_store_n(&ring->producer_waiting, 0, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        // Copy as much as fits, wrapping around the end of the area
+        const size_t count = size < room ? size : (size_t) room;
+        const size_t offset = (size_t) (head & mask);
+        const size_t first = count < ring->capacity - offset ? count : ring->capacity - offset;
+        memcpy(area + offset, data, first);
+        memcpy(area, data + first, count - first);
+
+        head += count;
+        data += count;
+        size -= count;
+
+        // Publish the bytes and wake the consumer if it sleeps
+        __atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->consumer_waiting, __ATOMIC_SEQ_CST))
+        {
+            stdi_futex_wake(&ring->head_sequence);
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Marks the end of the data written into a ring.
+ *
+ * Must only be called by the producer. The consumer reads the remaining
+ * bytes and then sees end of input.
+ *
+ * @param ring The ring to close.
+ */
+static inline void stdi_ring_close(stdi_ring_t *ring)
+{
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_SEQ_CST);
+    stdi_futex_wake(&ring->head_sequence);
+}
+
+/**
+ * @brief Tells the producer that nothing more will be read from a ring.
+ *
+ * Must only be called by the consumer, once it will not read the ring
+ * again from any reader. A producer blocked on a full ring returns from
+ * stdi_ring_write with FALSE. Destroying a reader does not abandon its
+ * ring, so another reader can pick the stream up, as it could with a pipe.
+ *
+ * @param ring The ring to abandon.
+ */
+static inline void stdi_ring_abandon(stdi_ring_t *ring)
+{
+    __atomic_store_n(&ring->abandoned, 1, __ATOMIC_SEQ_CST);
+    stdi_futex_wake(&ring->tail_sequence);
+}
+
+/**
+ * @brief Reads up to `size` bytes from a ring, blocking while it is empty.
+ *
+ * Must only be called by the consumer.
+ *
+ * @param ring The ring to read from.
+ * @param buffer A pointer to the buffer where the read data will be stored.
+ * @param size The maximum number of bytes to read.
+ * @return The number of bytes read, or 0 once the ring is closed and drained.
+ */
+static inline ssize_t stdi_ring_read(stdi_ring_t *ring, char *buffer, const size_t size)
+{
+    const char *area = (const char *) ring + STDI_RING_HEADER_SIZE;
+    const uint64_t mask = ring->capacity - 1;
+    const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    while (TRUE)
+    {
+        // Check `closed` first, bytes written before closing are then visible
+        const bool closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+        const uint64_t available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+
+        if (available > 0)
+        {
+            // Copy as much as requested, wrapping around the end of the area
+            const size_t count = size < available ? size : (size_t) available;
+            const size_t offset = (size_t) (tail & mask);
+            const size_t first = count < ring->capacity - offset ? count : ring->capacity - offset;
+            memcpy(buffer, area + offset, first);
+            memcpy(buffer + first, area, count - first);
+
+            // Release the space and wake the producer if it sleeps
+            __atomic_store_n(&ring->tail, tail + count, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&ring->producer_waiting, __ATOMIC_SEQ_CST))
+            {
+                stdi_futex_wake(&ring->tail_sequence);
+            }
+
+            return (ssize_t) count;
+        }
+
+        if (closed)
+        {
+            return 0;
+        }
+
+        // Announce the sleep, then recheck to not miss a wakeup
+        const uint32_t sequence = __atomic_load_n(&ring->head_sequence, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&ring->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail
+            && !__atomic_load_n(&ring->closed, __ATOMIC_SEQ_CST))
+        {
+            stdi_futex_wait(&ring->head_sequence, sequence);
+        }
+
+        __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Source encodings supported by the reader's transcoding stage.
+ */
+typedef enum
+{
+    STDI_ENCODING_UTF8,     // No transcoding
+    STDI_ENCODING_UTF16LE,  // UTF-16 little endian
+    STDI_ENCODING_UTF16BE,  // UTF-16 big endian
+    STDI_ENCODING_LATIN1    // ISO-8859-1
+} stdi_encoding_t;
+
+/**
+ * @brief What happens to a reader's buffered bytes when the process forks.
+ *
+ * Both processes share the descriptor's file offset, so bytes buffered
+ * before fork() would otherwise be handed out twice, once by each side.
+ */
+typedef enum
+{
+    STDI_FORK_DUPLICATE,        // Both sides keep the buffered bytes (the default, nothing is tracked)
+    STDI_FORK_KEEP_IN_PARENT,   // The child discards them
+    STDI_FORK_KEEP_IN_CHILD,    // The parent discards them
+    STDI_FORK_DISCARD           // Both sides discard them
+} stdi_fork_policy_t;
+
+/**
+ * @brief A buffered reader over a file descriptor.
+ *
+ * The reader pulls large blocks from its file descriptor and hands out
+ * lines as views into its internal buffer. Besides the buffered bytes it
+ * keeps track of the absolute stream offset and the number of lines consumed,
+ * so its position can be checkpointed and restored later on.
+ */
+typedef struct stdi_reader
+{
+    int fd;             // Source file descriptor
+    char *buffer;       // Heap-allocated read buffer
+    size_t capacity;    // Size of the buffer in bytes
+    size_t start;       // Index of the first unconsumed byte
+    size_t end;         // Index one past the last buffered byte
+    off_t base_offset;  // Absolute stream offset of buffer[0]
+    size_t line;        // Number of lines consumed so far
+    off_t line_start;   // Absolute offset where the current line starts
+    off_t last_line;    // Absolute offset where the last returned line starts
+    bool eof;           // Whether the source reported end of input
+    bool error;         // Whether the source reported an error
+    stdi_encoding_t encoding;   // Encoding of the source bytes
+    char *raw;                  // Undecoded source bytes, only used when transcoding
+    size_t raw_length;          // Number of pending bytes in `raw`
+    size_t raw_capacity;        // Size of `raw` in bytes
+    bool raw_eof;               // Whether the source reported end of input while transcoding
+    bool raw_bom;               // Whether a byte order mark may still have to be skipped
+    stdi_writer_t *tied;        // Writer flushed before reads, according to its policy
+    size_t generation;          // Bumped whenever buffered bytes move or get overwritten
+    stdi_ring_t *ring;          // Shared-memory ring read instead of the descriptor, or NULL
+    stdi_fork_policy_t fork_policy;     // What happens to buffered bytes on fork()
+    struct stdi_reader *fork_next;      // Next reader in the fork registry
+} stdi_reader_t;
+
+/**
+ * @brief A consistent snapshot of a reader's position.
+ *
+ * The offset refers to the first byte that has not been consumed yet,
+ * buffered-but-unconsumed bytes are therefore not counted as read.
+ */
+typedef struct
+{
+    off_t offset;       // Absolute offset of the next unconsumed byte
+    size_t line;        // Number of lines consumed before the offset
+    off_t line_start;   // Absolute offset where the current line starts
+} stdi_checkpoint_t;
+
+/**
+ * @brief A human-readable position in a stream, meant for diagnostics.
+ */
+typedef struct
+{
+    off_t offset;   // Absolute byte offset (0-based)
+    size_t line;    // Line number (1-based)
+    size_t column;  // Byte column within the line (1-based)
+} stdi_position_t;
+
+/**
+ * @brief Input formats recognized by stdi_detect_format.
+ */
+typedef enum
+{
+    STDI_FORMAT_EMPTY,      // No input at all
+    STDI_FORMAT_TEXT,       // Plain text without a recognized structure
+    STDI_FORMAT_UTF8_BOM,   // Text starting with a UTF-8 byte order mark
+    STDI_FORMAT_UTF16LE,    // UTF-16 little endian text
+    STDI_FORMAT_UTF16BE,    // UTF-16 big endian text
+    STDI_FORMAT_NDJSON,     // Newline-delimited JSON
+    STDI_FORMAT_CSV,        // Comma-separated values
+    STDI_FORMAT_TSV,        // Tab-separated values
+    STDI_FORMAT_GZIP,       // gzip-compressed data
+    STDI_FORMAT_ZSTD,       // Zstandard-compressed data
+    STDI_FORMAT_BINARY,     // Anything else that is not text
+    STDI_FORMAT_ERROR       // The input could not be read, reader->error is set
+} stdi_format_t;
+
+/**
+ * @brief Byte statistics gathered over a block by stdi_scan_format_stats.
+ */
+typedef struct
+{
+    size_t newlines;    // Number of '\n' bytes
+    size_t commas;      // Number of ',' bytes
+    size_t tabs;        // Number of '\t' bytes
+    size_t controls;    // Number of control bytes other than '\t', '\n' and '\r'
+    size_t nul_even;    // Number of NUL bytes at even indexes
+    size_t nul_odd;     // Number of NUL bytes at odd indexes
+} stdi_format_stats_t;
+
+/**
+ * @brief Counts the newlines in a block of memory.
+ *
+ * When SSE2 is available, the block is compared 16 bytes at a time and
+ * the resulting newline bitmaps are counted with popcount.
+ *
+ * @param data A pointer to the data to scan.
+ * @param size The number of bytes to scan.
+ * @param last Receives the index of the last newline, or `size` if none was found.
+ * @return The number of newlines found.
+ */
+static inline size_t stdi_scan_newlines(const char *data, const size_t size, size_t *last)
+{
+    size_t count = 0;
+    size_t i = 0;
+    *last = size;
+
+#   if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16)
+    {
+        // Build a bitmap of the newlines in this block
+        const __m128i block = _mm_loadu_si128((const __m128i *) (data + i));
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+
+        if (mask != 0)
+        {
+            count += __builtin_popcount(mask);
+            *last = i + 31 - __builtin_clz(mask);
+        }
+    }
+#   endif
+
+    // Handle the remaining bytes
+    for (; i < size; i++)
+    {
+        if (data[i] == '\n')
+        {
+            count++;
+            *last = i;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Reads up to `size` bytes from a file descriptor, retrying on EINTR.
+ *
+ * @param fd The file descriptor to read from.
+ * @param buffer A pointer to the buffer where the read data will be stored.
+ * @param size The maximum number of bytes to read.
+ * @return The number of bytes read, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_fd_read(const int fd, char *buffer, const size_t size)
+{
+    while (TRUE)
+    {
+        const ssize_t bytes_read = syscall(SYS_read, fd, buffer, size);
+
+        // Retry if we got interrupted by a signal
+        if (bytes_read == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        return bytes_read;
+    }
+}
+
+/**
+ * @brief Initializes a buffered reader over a file descriptor.
+ *
+ * If the file descriptor is seekable, the current file position is used
+ * as the starting offset, otherwise the offset starts at zero. A reader over
+ * STDIN_FILENO takes over the bytes read_line() buffered, so lines read
+ * with it and with the reader are neither lost nor merged.
+ *
+ * If the descriptor is a shared-memory ring (see stdi_ring_create), or it
+ * is STDIN_FILENO and STDI_RING_ENV names a ring descriptor, the ring is
+ * read instead. A ring attached through STDI_RING_ENV is hidden from
+ * children: the variable is removed from the environment and the descriptor
+ * it names is made close-on-exec. A ring passed as `fd` itself is left
+ * inheritable, just like a pipe, since making stdin close-on-exec would
+ * hand later children a closed stdin.
+ *
+ * @param reader The reader to initialize.
+ * @param fd The file descriptor to read from (e.g. STDIN_FILENO).
+ * @param capacity The initial buffer size, or 0 to use STDI_READER_BUFFER_SIZE.
+ * @return TRUE on success, FALSE if the buffer could not be allocated.
+ */
+static inline bool stdi_reader_init(stdi_reader_t *reader, const int fd, size_t capacity)
+{
+    // Fall back to the default buffer size
+    if (capacity == 0)
+    {
+        capacity = STDI_READER_BUFFER_SIZE;
+    }
+
+    // Always leave room for one transcoded character
+    if (capacity < 4)
+    {
+        capacity = 4;
+    }
+
+    // Make room for the stdin bytes read_line() buffered, they are taken over below
+    const size_t handed = fd == STDIN_FILENO ? stdi_stdin_buffer.end - stdi_stdin_buffer.start : 0;
+    if (capacity < handed)
+    {
+        capacity = handed;
+    }
+
+    // Allocate the buffer
+    reader->buffer = malloc(sizeof(char) * capacity);
+    if (reader->buffer == NULL)
+    {
+        return FALSE;
+    }
+
+    // Consume a shared-memory ring instead of the descriptor when one is passed
+    stdi_ring_t *ring = stdi_ring_open(fd);
+    const char *variable = fd == STDIN_FILENO && ring == NULL ? getenv(STDI_RING_ENV) : NULL;
+    if (variable != NULL && *variable != '\0')
+    {
+        const int ring_fd = atoi(variable);
+        ring = stdi_ring_open(ring_fd);
+
+        // Keep our children from attaching as a second consumer. Only the
+        // descriptor named by the variable is made close-on-exec, stdin itself
+        // is left alone so children never start with it closed.
+        if (ring != NULL)
+        {
+            unsetenv(STDI_RING_ENV);
+            fcntl(ring_fd, F_SETFD, fcntl(ring_fd, F_GETFD) | FD_CLOEXEC);
+        }
+    }
+
+    // Start counting from the current position if the descriptor is seekable
+    const off_t position = ring == NULL ? lseek(fd, 0, SEEK_CUR) : 0;
+
+    reader->fd = fd;
+    reader->capacity = capacity;
+    reader->start = 0;
+    reader->end = 0;
+    reader->base_offset = position == -1 ? 0 : position;
+    reader->line = 0;
+    reader->line_start = reader->base_offset;
+    reader->last_line = reader->base_offset;
+    reader->eof = FALSE;
+    reader->error = FALSE;
+    reader->encoding = STDI_ENCODING_UTF8;
+    reader->raw = NULL;
+    reader->raw_length = 0;
+    reader->raw_capacity = 0;
+    reader->raw_eof = FALSE;
+    reader->raw_bom = FALSE;
+    reader->tied = NULL;
+    reader->generation = 0;
+    reader->ring = ring;
+    reader->fork_policy = STDI_FORK_DUPLICATE;
+    reader->fork_next = NULL;
+
+    // Take over the bytes read_line() read past its last line, so they are not lost
+    if (ring == NULL && handed > 0)
+    {
+        memcpy(reader->buffer, stdi_stdin_buffer.data + stdi_stdin_buffer.start, handed);
+        stdi_stdin_buffer.start = 0;
+        stdi_stdin_buffer.end = 0;
+        reader->end = handed;
+        reader->base_offset -= position == -1 ? 0 : (off_t) handed;
+        reader->line_start = reader->base_offset;
+        reader->last_line = reader->base_offset;
+    }
+
+    return TRUE;
+}
+
+// Registry of readers with a fork policy, weak so every translation unit shares it
+pthread_mutex_t stdi_fork_mutex __attribute__((weak)) = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t stdi_fork_once __attribute__((weak)) = PTHREAD_ONCE_INIT;
+struct stdi_reader *stdi_fork_readers __attribute__((weak)) = NULL;
+
+/**
+ * @brief Drops the bytes a reader has buffered, as if another process consumed them.
+ *
+ * The reader's line count is not updated, since the other side reads those
+ * lines. Readers over a shared-memory ring reach end of input instead, the
+ * ring only supports a single consumer.
+ *
+ * @param reader The reader to drop the bytes of.
+ */
+static inline void stdi_reader_discard(stdi_reader_t *reader)
+{
+    reader->base_offset += (off_t) reader->end;
+    reader->start = 0;
+    reader->end = 0;
+    reader->raw_length = 0;
+    reader->line_start = reader->base_offset;
+    reader->generation++;
+
+    if (reader->ring != NULL)
+    {
+        stdi_ring_unmap(reader->ring);
+        reader->ring = NULL;
+        reader->eof = TRUE;
+    }
+}
+
+/**
+ * @brief Applies the fork policies of the registered readers on one side of a fork.
+ *
+ * @param child Whether this runs in the child process.
+ */
+static inline void stdi_fork_apply(const bool child)
+{
+    for (struct stdi_reader *reader = stdi_fork_readers; reader != NULL; reader = reader->fork_next)
+    {
+        const stdi_fork_policy_t keep = child ? STDI_FORK_KEEP_IN_CHILD : STDI_FORK_KEEP_IN_PARENT;
+        if (reader->fork_policy != keep)
+        {
+            stdi_reader_discard(reader);
+        }
+    }
+
+    pthread_mutex_unlock(&stdi_fork_mutex);
+}
+
+/**
+ * @brief pthread_atfork handler run before fork(), keeps the registry stable.
+ */
+static inline void stdi_fork_prepare()
+{
+    pthread_mutex_lock(&stdi_fork_mutex);
+}
+
+/**
+ * @brief pthread_atfork handler run in the parent after fork().
+ */
+static inline void stdi_fork_parent()
+{
+    stdi_fork_apply(FALSE);
+}
+
+/**
+ * @brief pthread_atfork handler run in the child after fork().
+ */
+static inline void stdi_fork_child()
+{
+    stdi_fork_apply(TRUE);
+}
+
+/**
+ * @brief Installs the fork handlers, once per process.
+ */
+static inline void stdi_fork_install()
+{
+    pthread_atfork(stdi_fork_prepare, stdi_fork_parent, stdi_fork_child);
+}
+
+/**
+ * @brief Removes a reader from the fork registry.
+ *
+ * @param reader The reader to remove.
+ */
+static inline void stdi_fork_unregister(stdi_reader_t *reader)
+{
+    pthread_mutex_lock(&stdi_fork_mutex);
+
+    for (struct stdi_reader **link = &stdi_fork_readers; *link != NULL; link = &(*link)->fork_next)
+    {
+        if (*link == reader)
+        {
+            *link = reader->fork_next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&stdi_fork_mutex);
+    reader->fork_next = NULL;
+}
+
+/**
+ * @brief Sets what happens to a reader's buffered bytes when the process forks.
+ *
+ * Readers with a policy other than STDI_FORK_DUPLICATE are tracked by
+ * address until they are destroyed, so they must not be moved or copied
+ * meanwhile. Discarded bytes are lost to that side only; reads after the
+ * fork continue from the shared file offset, as unbuffered reads would.
+ *
+ * The policy is applied by pthread_atfork handlers, so it covers fork()
+ * but not raw clone() or vfork() calls. A reader in use by another thread
+ * while forking is left in whatever state that thread reached.
+ *
+ * @param reader The reader to configure.
+ * @param policy The fork policy.
+ * @return TRUE on success, FALSE if the fork handlers could not be installed.
+ */
+static inline bool stdi_reader_set_fork_policy(stdi_reader_t *reader, const stdi_fork_policy_t policy)
+{
+    if (pthread_once(&stdi_fork_once, stdi_fork_install) != 0)
+    {
+        return FALSE;
+    }
+
+    // Untrack the reader first, so it is never registered twice
+    if (reader->fork_policy != STDI_FORK_DUPLICATE)
+    {
+        stdi_fork_unregister(reader);
+    }
+
+    reader->fork_policy = policy;
+    if (policy == STDI_FORK_DUPLICATE)
+    {
+        return TRUE;
+    }
+
+    pthread_mutex_lock(&stdi_fork_mutex);
+    reader->fork_next = stdi_fork_readers;
+    stdi_fork_readers = reader;
+    pthread_mutex_unlock(&stdi_fork_mutex);
+    return TRUE;
+}
+
+/**
+ * @brief Releases the memory held by a reader.
+ *
+ * The underlying file descriptor is not closed. A shared-memory ring is only
+ * unmapped, so another reader may keep consuming it; call stdi_ring_abandon
+ * first to tell the producer that nothing more will be read.
+ *
+ * @param reader The reader to destroy.
+ */
+static inline void stdi_reader_destroy(stdi_reader_t *reader)
+{
+    if (reader->fork_policy != STDI_FORK_DUPLICATE)
+    {
+        stdi_fork_unregister(reader);
+        reader->fork_policy = STDI_FORK_DUPLICATE;
+    }
+
+    if (reader->ring != NULL)
+    {
+        stdi_ring_unmap(reader->ring);
+        reader->ring = NULL;
+    }
+
+    free(reader->buffer);
+    free(reader->raw);
+    reader->buffer = NULL;
+    reader->raw = NULL;
+    reader->capacity = 0;
+    reader->raw_capacity = 0;
+    reader->start = 0;
+    reader->end = 0;
+}
+
+/**
+ * @brief Reads up to `size` source bytes for a reader, from its ring or its descriptor.
+ *
+ * @param reader The reader to read for.
+ * @param buffer A pointer to the buffer where the read data will be stored.
+ * @param size The maximum number of bytes to read.
+ * @return The number of bytes read, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_reader_read_source(stdi_reader_t *reader, char *buffer, const size_t size)
+{
+    return reader->ring != NULL
+        ? stdi_ring_read(reader->ring, buffer, size)
+        : stdi_fd_read(reader->fd, buffer, size);
+}
+
+/**
+ * @brief Ties a writer to a reader.
+ *
+ * If the writer uses STDI_FLUSH_BEFORE_READ, its pending output is flushed
+ * whenever the reader is about to block waiting for input, which is what
+ * prompt/response tools need. When input is already available, nothing is
+ * flushed, so output keeps being coalesced.
+ *
+ * @param reader The reader to tie the writer to.
+ * @param writer The writer to tie, or NULL to untie.
+ */
+static inline void stdi_reader_tie(stdi_reader_t *reader, stdi_writer_t *writer)
+{
+    reader->tied = writer;
+}
+
+/**
+ * @brief Encodes a code point as UTF-8.
+ *
+ * @param code_point The code point to encode.
+ * @param output A pointer to at least 4 writable bytes.
+ * @return The number of bytes written.
+ */
+static inline size_t stdi_utf8_encode(const uint32_t code_point, char *output)
+{
+    if (code_point < 0x80)
+    {
+        output[0] = (char) code_point;
+        return 1;
+    }
+
+    if (code_point < 0x800)
+    {
+        output[0] = (char) (0xC0 | (code_point >> 6));
+        output[1] = (char) (0x80 | (code_point & 0x3F));
+        return 2;
+    }
+
+    if (code_point < 0x10000)
+    {
+        output[0] = (char) (0xE0 | (code_point >> 12));
+        output[1] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        output[2] = (char) (0x80 | (code_point & 0x3F));
+        return 3;
+    }
+
+    output[0] = (char) (0xF0 | (code_point >> 18));
+    output[1] = (char) (0x80 | ((code_point >> 12) & 0x3F));
+    output[2] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+    output[3] = (char) (0x80 | (code_point & 0x3F));
+    return 4;
+}
+
+/**
+ * @brief Transcodes Latin-1 into UTF-8.
+ *
+ * ASCII blocks are copied 16 bytes at a time when SSE2 is available.
+ *
+ * @param input The Latin-1 bytes.
+ * @param size The number of input bytes.
+ * @param output The output buffer.
+ * @param capacity The size of the output buffer.
+ * @param consumed Receives the number of input bytes that were transcoded.
+ * @return The number of bytes written.
+ */
+static inline size_t stdi_transcode_latin1(
+    const unsigned char *input,
+    const size_t size,
+    char *output,
+    const size_t capacity,
+    size_t *consumed
+)
+{
+    size_t i = 0;
+    size_t written = 0;
+
+    while (i < size)
+    {
+#       if defined(__SSE2__)
+        // Copy whole ASCII blocks at once
+        if (i + 16 <= size && written + 16 <= capacity)
+        {
+            const __m128i block = _mm_loadu_si128((const __m128i *) (input + i));
+            if (_mm_movemask_epi8(block) == 0)
+            {
+                _mm_storeu_si128((__m128i *) (output + written), block);
+                i += 16;
+                written += 16;
+                continue;
+            }
+        }
+#       endif
+
+        // Stop if the character might not fit
+        if (written + 2 > capacity)
+        {
+            break;
+        }
+
+        written += stdi_utf8_encode(input[i], output + written);
+        i++;
+    }
+
+    *consumed = i;
+    return written;
+}
+
+/**
+ * @brief Transcodes UTF-16 into UTF-8.
+ *
+ * Blocks of 8 ASCII code units are narrowed at once when SSE2 is available.
+ * Unpaired surrogates are replaced with U+FFFD.
+ *
+ * @param input The UTF-16 bytes.
+ * @param size The number of input bytes.
+ * @param big_endian Whether the input is big endian.
+ * @param final Whether no more input follows, so incomplete sequences must be flushed.
+ * @param output The output buffer.
+ * @param capacity The size of the output buffer.
+ * @param consumed Receives the number of input bytes that were transcoded.
+ * @return The number of bytes written.
+ */
+static inline size_t stdi_transcode_utf16(
+    const unsigned char *input,
+    const size_t size,
+    const bool big_endian,
+    const bool final,
+    char *output,
+    const size_t capacity,
+    size_t *consumed
+)
+{
+    size_t i = 0;
+    size_t written = 0;
+
+    while (i + 1 < size)
+    {
+#       if defined(__SSE2__)
+        // Narrow whole ASCII blocks at once
+        if (i + 16 <= size && written + 8 <= capacity)
+        {
+            __m128i block = _mm_loadu_si128((const __m128i *) (input + i));
+            if (big_endian)
+            {
+                block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+            }
+
+            const __m128i high = _mm_and_si128(block, _mm_set1_epi16((short) 0xFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF)
+            {
+                _mm_storel_epi64((__m128i *) (output + written), _mm_packus_epi16(block, block));
+                i += 16;
+                written += 8;
+                continue;
+            }
+        }
+#       endif
+
+        // Stop if the character might not fit
+        if (written + 4 > capacity)
+        {
+            break;
+        }
+
+        const uint32_t unit = big_endian
+            ? ((uint32_t) input[i] << 8) | input[i + 1]
+            : ((uint32_t) input[i + 1] << 8) | input[i];
+
+        // Handle surrogate pairs
+        if (unit >= 0xD800 && unit <= 0xDBFF)
+        {
+            // Wait for the low surrogate
+            if (i + 3 >= size && !final)
+            {
+                break;
+            }
+
+            const uint32_t low = i + 3 >= size ? 0 : big_endian
+                ? ((uint32_t) input[i + 2] << 8) | input[i + 3]
+                : ((uint32_t) input[i + 3] << 8) | input[i + 2];
+
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                written += stdi_utf8_encode(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), output + written);
+                i += 4;
+                continue;
+            }
+
+            written += stdi_utf8_encode(0xFFFD, output + written);
+        }
+        else if (unit >= 0xDC00 && unit <= 0xDFFF)
+        {
+            written += stdi_utf8_encode(0xFFFD, output + written);
+        }
+        else
+        {
+            written += stdi_utf8_encode(unit, output + written);
+        }
+
+        i += 2;
+    }
+
+    *consumed = i;
+    return written;
+}
+
+/**
+ * @brief Reads and transcodes source bytes into a reader's buffer.
+ *
+ * @param reader The reader to transcode for.
+ * @param output Where the UTF-8 output is written.
+ * @param capacity The size of the output area, at least 4 bytes.
+ * @return The number of bytes written, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_reader_transcode(stdi_reader_t *reader, char *output, const size_t capacity)
+{
+    while (TRUE)
+    {
+        // Skip a byte order mark at the start of the decoded stream
+        const unsigned char *raw = (const unsigned char *) reader->raw;
+        if (reader->raw_bom && (reader->raw_length >= 2 || reader->raw_eof))
+        {
+            if (reader->raw_length >= 2
+                && ((reader->encoding == STDI_ENCODING_UTF16LE && raw[0] == 0xFF && raw[1] == 0xFE)
+                    || (reader->encoding == STDI_ENCODING_UTF16BE && raw[0] == 0xFE && raw[1] == 0xFF)))
+            {
+                memmove(reader->raw, reader->raw + 2, reader->raw_length - 2);
+                reader->raw_length -= 2;
+            }
+
+            reader->raw_bom = FALSE;
+        }
+
+        // Transcode the pending bytes first, staged lines must not wait for a read
+        size_t written = 0;
+        if (!reader->raw_bom && reader->raw_length > 0)
+        {
+            size_t consumed;
+            if (reader->encoding == STDI_ENCODING_LATIN1)
+            {
+                written = stdi_transcode_latin1(
+                    (const unsigned char *) reader->raw,
+                    reader->raw_length,
+                    output,
+                    capacity,
+                    &consumed
+                );
+            }
+            else
+            {
+                written = stdi_transcode_utf16(
+                    (const unsigned char *) reader->raw,
+                    reader->raw_length,
+                    reader->encoding == STDI_ENCODING_UTF16BE,
+                    reader->raw_eof,
+                    output,
+                    capacity,
+                    &consumed
+                );
+            }
+
+            // Keep the bytes that could not be transcoded yet
+            memmove(reader->raw, reader->raw + consumed, reader->raw_length - consumed);
+            reader->raw_length -= consumed;
+        }
+
+        if (written > 0)
+        {
+            return (ssize_t) written;
+        }
+
+        if (reader->raw_eof)
+        {
+            // Replace a dangling byte at the end of input
+            if (reader->raw_length > 0)
+            {
+                reader->raw_length = 0;
+                return (ssize_t) stdi_utf8_encode(0xFFFD, output);
+            }
+
+            return 0;
+        }
+
+        // Only read when the pending bytes are empty or incomplete
+        const ssize_t bytes_read = stdi_reader_read_source(
+            reader,
+            reader->raw + reader->raw_length,
+            reader->raw_capacity - reader->raw_length
+        );
+
+        if (bytes_read == -1)
+        {
+            return -1;
+        }
+
+        reader->raw_eof = bytes_read == 0;
+        reader->raw_length += bytes_read;
+    }
+}
+
+/**
+ * @brief Sets the encoding of a reader's source, enabling the transcoding stage.
+ *
+ * Once set, every reader API returns UTF-8. Bytes that are buffered but not
+ * consumed yet (e.g. after stdi_detect_format) are transcoded as well, and a
+ * byte order mark matching the encoding is skipped. Offsets reported from
+ * then on refer to the transcoded stream, so checkpoints cannot be resumed
+ * while transcoding.
+ *
+ * @param reader The reader to configure.
+ * @param encoding The encoding of the source bytes.
+ * @return TRUE on success, FALSE if the staging buffer could not be allocated.
+ */
+static inline bool stdi_reader_set_encoding(stdi_reader_t *reader, const stdi_encoding_t encoding)
+{
+    if (encoding == STDI_ENCODING_UTF8 || reader->encoding != STDI_ENCODING_UTF8)
+    {
+        return encoding == reader->encoding;
+    }
+
+    // Size the staging buffer so transcoded output fits the main buffer,
+    // it must at least hold a surrogate pair to make progress
+    const size_t pending = reader->end - reader->start;
+    size_t capacity = reader->capacity / 2;
+    if (capacity < 16)
+    {
+        capacity = 16;
+    }
+
+    if (capacity < pending)
+    {
+        capacity = pending;
+    }
+
+    reader->raw = malloc(sizeof(char) * capacity);
+    if (reader->raw == NULL)
+    {
+        return FALSE;
+    }
+
+    // Move the buffered bytes into the staging buffer
+    memcpy(reader->raw, reader->buffer + reader->start, pending);
+    reader->raw_length = pending;
+    reader->raw_capacity = capacity;
+    reader->raw_eof = reader->eof;
+    reader->encoding = encoding;
+    reader->base_offset += (off_t) reader->start;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = FALSE;
+    reader->generation++;
+
+    // Skip a byte order mark once the first two bytes are available
+    reader->raw_bom = encoding != STDI_ENCODING_LATIN1;
+    return TRUE;
+}
+
+/**
+ * @brief Checks whether reading from the reader's source would block right now.
+ *
+ * @param reader The reader to check.
+ * @return TRUE if no input is ready to be read.
+ */
+static inline bool stdi_reader_would_block(const stdi_reader_t *reader)
+{
+    struct pollfd descriptor = { reader->fd, POLLIN, 0 };
+    return reader->ring != NULL ? stdi_ring_available(reader->ring) == 0 : poll(&descriptor, 1, 0) == 0;
+}
+
+/**
+ * @brief Reads more data into the reader's buffer.
+ *
+ * Unconsumed bytes are kept. If the buffer is full of unconsumed bytes,
+ * it is grown to make room for more data.
+ *
+ * @param reader The reader to refill.
+ * @return The number of bytes read, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_reader_fill(stdi_reader_t *reader)
+{
+    // Move the unconsumed bytes to the front of the buffer
+    // (leave room for at least one transcoded character)
+    if (reader->start > 0 && reader->capacity - reader->end < 4)
+    {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->base_offset += reader->start;
+        reader->end -= reader->start;
+        reader->start = 0;
+        reader->generation++;
+    }
+
+    // Grow the buffer if it is still full
+    if (reader->capacity - reader->end < 4)
+    {
+        STDI_PROBE2(realloc, reader->capacity, reader->capacity * 2);
+        char *new_buffer = realloc(reader->buffer, sizeof(char) * reader->capacity * 2);
+        if (new_buffer == NULL)
+        {
+            STDI_PROBE2(error, reader->fd, ENOMEM);
+            reader->error = TRUE;
+            return -1;
+        }
+
+        reader->buffer = new_buffer;
+        reader->capacity *= 2;
+        reader->generation++;
+    }
+
+    // Flush the tied writer if the read would block
+    stdi_writer_t *tied = reader->tied;
+    if (tied != NULL && tied->length > 0 && tied->policy == STDI_FLUSH_BEFORE_READ && stdi_reader_would_block(reader))
+    {
+        stdi_writer_flush(tied);
+    }
+
+    STDI_PROBE2(refill__start, reader->fd, reader->capacity - reader->end);
+    STDI_HISTOGRAM_START(started);
+    const ssize_t bytes_read = reader->encoding == STDI_ENCODING_UTF8
+        ? stdi_reader_read_source(reader, reader->buffer + reader->end, reader->capacity - reader->end)
+        : stdi_reader_transcode(reader, reader->buffer + reader->end, reader->capacity - reader->end);
+    STDI_HISTOGRAM_STOP(STDI_HISTOGRAM_READ, started);
+    STDI_PROBE2(refill__end, reader->fd, bytes_read);
+
+    // Handle errors
+    if (bytes_read == -1)
+    {
+        STDI_PROBE2(error, reader->fd, errno);
+        reader->error = TRUE;
+        return -1;
+    }
+
+    // Check for end of input
+    if (bytes_read == 0)
+    {
+        reader->eof = TRUE;
+        return 0;
+    }
+
+    reader->end += bytes_read;
+    return bytes_read;
+}
+
+/**
+ * @brief Reads the next line from a reader without copying it, reporting how reading ended.
+ *
+ * The line refers to the reader's internal buffer and is only guaranteed
+ * to be valid until the next call on the same reader (see stdi_line_t for
+ * a handle that can outlive it). The trailing newline is consumed but not
+ * included in the line. Once the end of input has been seen, it is
+ * remembered, so later calls return STDI_STATUS_EOF without a syscall.
+ *
+ * @param reader The reader to read from.
+ * @param line Receives a pointer to the start of the line, or NULL on EOF and errors.
+ * @param length Receives the length of the line in bytes.
+ * @return STDI_STATUS_LINE for a newline-terminated line, STDI_STATUS_PARTIAL for a
+ *         final line without a newline, STDI_STATUS_EOF or STDI_STATUS_ERROR.
+ */
+static inline stdi_status_t stdi_reader_read_line(stdi_reader_t *reader, const char **line, size_t *length)
+{
+    STDI_HISTOGRAM_LINE_BEGIN();
+
+    // Track how much of the buffer has been scanned already
+    size_t scanned = 0;
+
+    while (TRUE)
+    {
+        const size_t available = reader->end - reader->start;
+        *line = reader->buffer + reader->start;
+
+        // Search for a newline in the bytes we have not scanned yet
+        const char *newline = memchr(*line + scanned, '\n', available - scanned);
+        if (newline != NULL)
+        {
+            *length = newline - *line;
+            reader->last_line = reader->line_start;
+            reader->start += *length + 1;
+            reader->line++;
+            reader->line_start = reader->base_offset + (off_t) reader->start;
+            STDI_PROBE1(line, *length);
+            STDI_HISTOGRAM_LINE_END();
+            return STDI_STATUS_LINE;
+        }
+
+        scanned = available;
+
+        // Refill the buffer
+        if (!reader->eof && !reader->error && stdi_reader_fill(reader) > 0)
+        {
+            continue;
+        }
+
+        // The failed refill may still have moved or grown the buffer
+        *line = reader->buffer + reader->start;
+
+        // Handle errors and the end of input
+        if (reader->error || available == 0)
+        {
+            *line = NULL;
+            *length = 0;
+            return reader->error ? STDI_STATUS_ERROR : STDI_STATUS_EOF;
+        }
+
+        // Return the final line without a trailing newline
+        *length = available;
+        reader->last_line = reader->line_start;
+        reader->start = reader->end;
+        STDI_PROBE1(line, *length);
+        STDI_HISTOGRAM_LINE_END();
+        return STDI_STATUS_PARTIAL;
+    }
+}
+
+/**
+ * @brief Reads the next line from a reader without copying it.
+ *
+ * Same as stdi_reader_read_line, except that a final line without a
+ * trailing newline is returned like any other line, and end of input and
+ * errors both yield NULL (check the reader's `error` flag to tell them apart).
+ *
+ * @param reader The reader to read from.
+ * @param length Receives the length of the line in bytes.
+ * @return A pointer to the start of the line, or NULL on end of input or error.
+ */
+static inline const char* stdi_reader_next_line(stdi_reader_t *reader, size_t *length)
+{
+    const char *line;
+    stdi_reader_read_line(reader, &line, length);
+    return line;
+}
+
+/**
+ * @brief Reads the next line from a reader into a caller-owned buffer.
+ *
+ * Similar to POSIX getline: `*buffer` is reused across calls and grown with
+ * realloc when a line does not fit, so steady-state reading does not
+ * allocate. The line is NUL-terminated for convenience, but the returned
+ * length is authoritative, so embedded NUL bytes are preserved.
+ *
+ * @param reader The reader to read from.
+ * @param buffer A pointer to a heap-allocated buffer, or to NULL.
+ * @param capacity A pointer to the size of `*buffer` (0 if `*buffer` is NULL).
+ * @return The length of the line without its newline, or -1 on end of input or error.
+ *
+ * @warning The caller is responsible for freeing `*buffer`, even if -1 is returned.
+ */
+static inline ssize_t stdi_getline(stdi_reader_t *reader, char **buffer, size_t *capacity)
+{
+    size_t length;
+    const char *line = stdi_reader_next_line(reader, &length);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    // Grow the buffer if needed (+1 for the null terminator)
+    if (*buffer == NULL || *capacity < length + 1)
+    {
+        size_t new_capacity = *capacity < STDI_READ_LINE_BUFFER_SIZE + 1
+            ? STDI_READ_LINE_BUFFER_SIZE + 1
+            : *capacity;
+
+        while (new_capacity < length + 1)
+        {
+            new_capacity *= 2;
+        }
+
+        STDI_PROBE2(realloc, *capacity, new_capacity);
+        char *new_buffer = realloc(*buffer, sizeof(char) * new_capacity);
+        if (new_buffer == NULL)
+        {
+            STDI_PROBE2(error, reader->fd, ENOMEM);
+            reader->error = TRUE;
+            return -1;
+        }
+
+        *buffer = new_buffer;
+        *capacity = new_capacity;
+    }
+
+    memcpy(*buffer, line, length);
+    (*buffer)[length] = '\0';
+    return (ssize_t) length;
+}
+
+/**
+ * @brief A line that stays a view into the reader's buffer until it is retained.
+ *
+ * Discarding a line costs nothing. Lines that have to outlive the reader's
+ * buffer are copied to the heap on demand with stdi_line_retain.
+ */
+typedef struct
+{
+    const char *data;   // The line bytes, without the newline
+    size_t length;      // The length of the line in bytes
+    char *owned;        // Heap copy once retained, NULL while the line is a view
+    size_t generation;  // Reader generation the view belongs to
+} stdi_line_t;
+
+/**
+ * @brief Reads the next line from a reader as a lazily materialized handle.
+ *
+ * The handle is overwritten, so a retained line must be moved elsewhere
+ * (or released) before the handle is reused.
+ *
+ * @param reader The reader to read from.
+ * @param line Receives the line.
+ * @return TRUE if a line was read, FALSE on end of input or error.
+ */
+static inline bool stdi_reader_next(stdi_reader_t *reader, stdi_line_t *line)
+{
+    const char *data = stdi_reader_next_line(reader, &line->length);
+    if (data == NULL)
+    {
+        return FALSE;
+    }
+
+    line->data = data;
+    line->owned = NULL;
+    line->generation = reader->generation;
+    return TRUE;
+}
+
+/**
+ * @brief Checks whether a line's bytes are still accessible.
+ *
+ * Retained lines are always valid. Views stay valid as long as the reader
+ * did not move or overwrite its buffered bytes, which is at least until the
+ * next call on the reader and often much longer.
+ *
+ * @param reader The reader the line was read from.
+ * @param line The line to check.
+ * @return TRUE if `line->data` can still be accessed.
+ */
+static inline bool stdi_line_valid(const stdi_reader_t *reader, const stdi_line_t *line)
+{
+    return line->owned != NULL || line->generation == reader->generation;
+}
+
+/**
+ * @brief Copies a line to the heap so it survives further reads.
+ *
+ * Retaining an already retained line does nothing. The copy is
+ * NUL-terminated for convenience.
+ *
+ * @param line The line to retain, must still be valid.
+ * @return TRUE on success, FALSE if the copy could not be allocated.
+ */
+static inline bool stdi_line_retain(stdi_line_t *line)
+{
+    if (line->owned != NULL)
+    {
+        return TRUE;
+    }
+
+    // Allocate the copy (+1 for the null terminator)
+    char *owned = malloc(sizeof(char) * (line->length + 1));
+    if (owned == NULL)
+    {
+        return FALSE;
+    }
+
+    memcpy(owned, line->data, line->length);
+    owned[line->length] = '\0';
+    line->owned = owned;
+    line->data = owned;
+    return TRUE;
+}
+
+/**
+ * @brief Releases the heap copy of a retained line.
+ *
+ * Releasing a view does nothing.
+ *
+ * @param line The line to release.
+ */
+static inline void stdi_line_release(stdi_line_t *line)
+{
+    free(line->owned);
+    line->owned = NULL;
+    line->data = NULL;
+    line->length = 0;
+}
+
+/**
+ * @brief An owned line with inline storage for short lines.
+ *
+ * Lines shorter than STDI_OWNED_LINE_INLINE_SIZE bytes (including the
+ * null terminator) are stored inside the struct, so only longer lines
+ * cost a heap allocation. Initialize with stdi_owned_line_init and
+ * release with stdi_owned_line_free.
+ */
+typedef struct
+{
+    size_t length;  // The length of the line in bytes
+    union
+    {
+        char inline_data[STDI_OWNED_LINE_INLINE_SIZE];  // Storage for short lines
+        char *heap;                                     // Storage for long lines
+    } storage;
+} stdi_owned_line_t;
+
+/**
+ * @brief Initializes an owned line to the empty string.
+ *
+ * @param line The line to initialize.
+ */
+static inline void stdi_owned_line_init(stdi_owned_line_t *line)
+{
+    line->length = 0;
+    line->storage.inline_data[0] = '\0';
+}
+
+/**
+ * @brief Checks whether an owned line keeps its bytes on the heap.
+ *
+ * @param line The line to check.
+ * @return TRUE if the line is heap-allocated.
+ */
+static inline bool stdi_owned_line_is_heap(const stdi_owned_line_t *line)
+{
+    return line->length >= STDI_OWNED_LINE_INLINE_SIZE;
+}
+
+/**
+ * @brief Gets the bytes of an owned line.
+ *
+ * @param line The line to read.
+ * @return A pointer to the NUL-terminated bytes, valid until the line is modified or freed.
+ */
+static inline const char* stdi_owned_line_data(const stdi_owned_line_t *line)
+{
+    return stdi_owned_line_is_heap(line) ? line->storage.heap : line->storage.inline_data;
+}
+
+/**
+ * @brief Releases the memory held by an owned line and resets it to the empty string.
+ *
+ * @param line The line to free.
+ */
+static inline void stdi_owned_line_free(stdi_owned_line_t *line)
+{
+    if (stdi_owned_line_is_heap(line))
+    {
+        free(line->storage.heap);
+    }
+
+    stdi_owned_line_init(line);
+}
+
+/**
+ * @brief Replaces the contents of an owned line.
+ *
+ * @param line The line to modify, must be initialized.
+ * @param data The new bytes, must not point into `line`.
+ * @param length The number of bytes.
+ * @return TRUE on success, FALSE if the heap copy could not be allocated (the line is left unchanged).
+ */
+static inline bool stdi_owned_line_set(stdi_owned_line_t *line, const char *data, const size_t length)
+{
+    // Short lines go inline
+    if (length < STDI_OWNED_LINE_INLINE_SIZE)
+    {
+        stdi_owned_line_free(line);
+        memcpy(line->storage.inline_data, data, length);
+        line->storage.inline_data[length] = '\0';
+        line->length = length;
+        return TRUE;
+    }
+
+    // Reuse the heap allocation if there is one (+1 for the null terminator)
+    char *heap = realloc(
+        stdi_owned_line_is_heap(line) ? line->storage.heap : NULL,
+        sizeof(char) * (length + 1)
+    );
+
+    if (heap == NULL)
+    {
+        return FALSE;
+    }
+
+    memcpy(heap, data, length);
+    heap[length] = '\0';
+    line->storage.heap = heap;
+    line->length = length;
+    return TRUE;
+}
+
+/**
+ * @brief Reads the next line from a reader into an owned line.
+ *
+ * @param reader The reader to read from.
+ * @param line The line to store into, must be initialized. Its previous contents are replaced.
+ * @return TRUE if a line was read, FALSE on end of input or error.
+ */
+static inline bool stdi_reader_next_owned(stdi_reader_t *reader, stdi_owned_line_t *line)
+{
+    size_t length;
+    const char *data = stdi_reader_next_line(reader, &length);
+    if (data == NULL)
+    {
+        return FALSE;
+    }
+
+    if (!stdi_owned_line_set(line, data, length))
+    {
+        STDI_PROBE2(error, reader->fd, ENOMEM);
+        reader->error = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief A block of memory owned by a string pool.
+ */
+typedef struct stdi_string_pool_block
+{
+    struct stdi_string_pool_block *next;    // The previously filled block
+    size_t used;                            // Number of bytes used
+    size_t capacity;                        // Number of bytes available in `data`
+    char data[];                            // The stored strings
+} stdi_string_pool_block_t;
+
+/**
+ * @brief An append-only arena packing strings back to back.
+ *
+ * Stored strings carry no per-allocation header or size-class rounding,
+ * which makes retaining millions of short lines far cheaper than one
+ * malloc per line. Strings stay valid until the pool is destroyed.
+ */
+typedef struct
+{
+    stdi_string_pool_block_t *head;     // The block currently filled
+    size_t block_size;                  // Capacity of regular blocks
+    size_t bytes;                       // Total number of bytes stored
+} stdi_string_pool_t;
+
+/**
+ * @brief Initializes an empty string pool.
+ *
+ * @param pool The pool to initialize.
+ * @param block_size The capacity of each block, or 0 to use STDI_STRING_POOL_BLOCK_SIZE.
+ */
+static inline void stdi_string_pool_init(stdi_string_pool_t *pool, const size_t block_size)
+{
+    pool->head = NULL;
+    pool->block_size = block_size == 0 ? STDI_STRING_POOL_BLOCK_SIZE : block_size;
+    pool->bytes = 0;
+}
+
+/**
+ * @brief Releases every string stored in a pool.
+ *
+ * @param pool The pool to destroy.
+ */
+static inline void stdi_string_pool_destroy(stdi_string_pool_t *pool)
+{
+    stdi_string_pool_block_t *block = pool->head;
+    while (block != NULL)
+    {
+        stdi_string_pool_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    pool->head = NULL;
+    pool->bytes = 0;
+}
+
+/**
+ * @brief Copies a string into a pool.
+ *
+ * Strings larger than a quarter of the block size get a block of their own,
+ * so they do not waste the remainder of the current block.
+ *
+ * @param pool The pool to store into.
+ * @param data The bytes to store.
+ * @param length The number of bytes.
+ * @return A pointer to the NUL-terminated copy, or NULL if a block could not be allocated.
+ */
+static inline const char* stdi_string_pool_store(stdi_string_pool_t *pool, const char *data, const size_t length)
+{
+    // +1 for the null terminator
+    const size_t size = length + 1;
+    stdi_string_pool_block_t *block = pool->head;
+
+    if (block == NULL || block->capacity - block->used < size)
+    {
+        const bool dedicated = size > pool->block_size / 4;
+        const size_t capacity = dedicated ? size : pool->block_size;
+
+        stdi_string_pool_block_t *new_block = malloc(sizeof(stdi_string_pool_block_t) + capacity);
+        if (new_block == NULL)
+        {
+            return NULL;
+        }
+
+        new_block->used = 0;
+        new_block->capacity = capacity;
+
+        // Keep filling the current block after a dedicated one
+        if (dedicated && block != NULL)
+        {
+            new_block->next = block->next;
+            block->next = new_block;
+        }
+        else
+        {
+            new_block->next = block;
+            pool->head = new_block;
+        }
+
+        block = new_block;
+    }
+
+    char *copy = block->data + block->used;
+    memcpy(copy, data, length);
+    copy[length] = '\0';
+    block->used += size;
+    pool->bytes += size;
+    return copy;
+}
+
+/**
+ * @brief Reads the next line from a reader and stores it in a string pool.
+ *
+ * @param reader The reader to read from.
+ * @param pool The pool to store the line in.
+ * @param length Receives the length of the line in bytes.
+ * @return A pointer to the NUL-terminated copy in the pool, or NULL on end of input or error.
+ */
+static inline const char* stdi_reader_next_pooled(stdi_reader_t *reader, stdi_string_pool_t *pool, size_t *length)
+{
+    const char *line = stdi_reader_next_line(reader, length);
+    if (line == NULL)
+    {
+        return NULL;
+    }
+
+    const char *copy = stdi_string_pool_store(pool, line, *length);
+    if (copy == NULL)
+    {
+        STDI_PROBE2(error, reader->fd, ENOMEM);
+        reader->error = TRUE;
+    }
+
+    return copy;
+}
+
+/**
+ * @brief Hashes a block of memory, 8 bytes at a time.
+ *
+ * This is a fast non-cryptographic hash meant for hash tables, do not use
+ * it where hash flooding is a concern.
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @param seed A seed to derive independent hash functions from.
+ * @return The 64-bit hash.
+ */
+static inline uint64_t stdi_hash(const char *data, const size_t length, const uint64_t seed)
+{
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = seed ^ (length * multiplier);
+    size_t i = 0;
+
+    // Mix whole words
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+
+    // Mix the remaining bytes
+    if (i < length)
+    {
+        uint64_t word = 0;
+        memcpy(&word, data + i, length - i);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+
+    // Finalize
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * @brief A string stored in an intern table.
+ */
+typedef struct
+{
+    const char *data;   // The NUL-terminated bytes, stored in the table's pool
+    size_t length;      // The length in bytes
+    uint64_t hash;      // The hash of the bytes
+} stdi_interned_t;
+
+/**
+ * @brief A deduplicating string table.
+ *
+ * Every distinct string is stored once in a string pool and gets a dense
+ * 32-bit ID. Interning the same bytes again returns the same ID and the
+ * same pointer, so equality checks become pointer (or ID) comparisons.
+ */
+typedef struct
+{
+    stdi_string_pool_t pool;    // Storage for the distinct strings
+    stdi_interned_t *entries;   // Distinct strings, indexed by ID
+    size_t count;               // Number of distinct strings
+    size_t capacity;            // Size of `entries`
+    uint32_t *slots;            // Open addressing table of ID + 1, 0 marks an empty slot
+    size_t slot_count;          // Size of `slots`, a power of two
+} stdi_intern_t;
+
+/**
+ * @brief Initializes an empty intern table.
+ *
+ * @param intern The table to initialize.
+ * @return TRUE on success, FALSE if an allocation failed.
+ */
+static inline bool stdi_intern_init(stdi_intern_t *intern)
+{
+    stdi_string_pool_init(&intern->pool, 0);
+    intern->count = 0;
+    intern->capacity = 64;
+    intern->slot_count = 128;
+    intern->entries = malloc(sizeof(stdi_interned_t) * intern->capacity);
+    intern->slots = calloc(intern->slot_count, sizeof(uint32_t));
+
+    if (intern->entries == NULL || intern->slots == NULL)
+    {
+        free(intern->entries);
+        free(intern->slots);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Releases every string and table held by an intern table.
+ *
+ * @param intern The table to destroy.
+ */
+static inline void stdi_intern_destroy(stdi_intern_t *intern)
+{
+    stdi_string_pool_destroy(&intern->pool);
+    free(intern->entries);
+    free(intern->slots);
+    intern->entries = NULL;
+    intern->slots = NULL;
+    intern->count = 0;
+}
+
+/**
+ * @brief Doubles the slot table of an intern table, rehashing from the stored hashes.
+ *
+ * @param intern The table to grow.
+ * @return TRUE on success, FALSE if the allocation failed.
+ */
+static inline bool stdi_intern_grow(stdi_intern_t *intern)
+{
+    const size_t slot_count = intern->slot_count * 2;
+    uint32_t *slots = calloc(slot_count, sizeof(uint32_t));
+    if (slots == NULL)
+    {
+        return FALSE;
+    }
+
+    for (size_t id = 0; id < intern->count; id++)
+    {
+        size_t slot = intern->entries[id].hash & (slot_count - 1);
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+
+        slots[slot] = (uint32_t) id + 1;
+    }
+
+    free(intern->slots);
+    intern->slots = slots;
+    intern->slot_count = slot_count;
+    return TRUE;
+}
+
+/**
+ * @brief Interns a string.
+ *
+ * @param intern The table to intern into.
+ * @param data The bytes to intern.
+ * @param length The number of bytes.
+ * @param id Receives the ID of the string, may be NULL.
+ * @return The canonical copy of the string, or NULL if an allocation failed,
+ *         in which case the table is left unchanged.
+ */
+static inline const char* stdi_intern(stdi_intern_t *intern, const char *data, const size_t length, uint32_t *id)
+{
+    const uint64_t hash = stdi_hash(data, length, 0);
+    size_t slot = hash & (intern->slot_count - 1);
+
+    // Probe for an existing copy
+    while (intern->slots[slot] != 0)
+    {
+        const stdi_interned_t *entry = &intern->entries[intern->slots[slot] - 1];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->data, data, length) == 0)
+        {
+            if (id != NULL)
+            {
+                *id = intern->slots[slot] - 1;
+            }
+
+            return entry->data;
+        }
+
+        slot = (slot + 1) & (intern->slot_count - 1);
+    }
+
+    // Make room for a new entry
+    if (intern->count == intern->capacity)
+    {
+        stdi_interned_t *entries = realloc(intern->entries, sizeof(stdi_interned_t) * intern->capacity * 2);
+        if (entries == NULL)
+        {
+            return NULL;
+        }
+
+        intern->entries = entries;
+        intern->capacity *= 2;
+    }
+
+    // Keep the load factor at or below one half, before anything is stored
+    if ((intern->count + 1) * 2 > intern->slot_count)
+    {
+        if (!stdi_intern_grow(intern))
+        {
+            return NULL;
+        }
+
+        // The slots were rehashed, find a free one again
+        slot = hash & (intern->slot_count - 1);
+        while (intern->slots[slot] != 0)
+        {
+            slot = (slot + 1) & (intern->slot_count - 1);
+        }
+    }
+
+    const char *copy = stdi_string_pool_store(&intern->pool, data, length);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+
+    // Insert into the free slot
+    const uint32_t new_id = (uint32_t) intern->count;
+    intern->entries[new_id].data = copy;
+    intern->entries[new_id].length = length;
+    intern->entries[new_id].hash = hash;
+    intern->slots[slot] = new_id + 1;
+    intern->count++;
+
+    if (id != NULL)
+    {
+        *id = new_id;
+    }
+
+    return copy;
+}
+
+/**
+ * @brief Looks up an interned string by ID.
+ *
+ * @param intern The table to look into.
+ * @param id The ID returned by stdi_intern.
+ * @param length Receives the length of the string, may be NULL.
+ * @return The canonical copy of the string, or NULL if the ID is unknown.
+ */
+static inline const char* stdi_intern_lookup(const stdi_intern_t *intern, const uint32_t id, size_t *length)
+{
+    if (id >= intern->count)
+    {
+        return NULL;
+    }
+
+    if (length != NULL)
+    {
+        *length = intern->entries[id].length;
+    }
+
+    return intern->entries[id].data;
+}
+
+/**
+ * @brief Reads the next line from a reader and interns it.
+ *
+ * The line is hashed straight from the reader's buffer, only lines that
+ * were not seen before are copied.
+ *
+ * @param reader The reader to read from.
+ * @param intern The table to intern into.
+ * @param id Receives the ID of the line, may be NULL.
+ * @return The canonical copy of the line, or NULL on end of input or error.
+ */
+static inline const char* stdi_reader_next_interned(stdi_reader_t *reader, stdi_intern_t *intern, uint32_t *id)
+{
+    size_t length;
+    const char *line = stdi_reader_next_line(reader, &length);
+    if (line == NULL)
+    {
+        return NULL;
+    }
+
+    const char *canonical = stdi_intern(intern, line, length, id);
+    if (canonical == NULL)
+    {
+        STDI_PROBE2(error, reader->fd, ENOMEM);
+        reader->error = TRUE;
+    }
+
+    return canonical;
+}
+
+/**
+ * @brief Takes a checkpoint of a reader's current position.
+ *
+ * The checkpoint accounts for buffered-but-unconsumed bytes, so resuming
+ * from it continues right after the last consumed line.
+ *
+ * @param reader The reader to take the checkpoint from.
+ * @param checkpoint Receives the current position.
+ */
+static inline void stdi_reader_checkpoint(const stdi_reader_t *reader, stdi_checkpoint_t *checkpoint)
+{
+    checkpoint->offset = reader->base_offset + (off_t) reader->start;
+    checkpoint->line = reader->line;
+    checkpoint->line_start = reader->line_start;
+}
+
+/**
+ * @brief Resumes a reader from a previously taken checkpoint.
+ *
+ * This only works when the reader's file descriptor refers to a regular
+ * file (not a shared-memory ring), since the position is restored through
+ * lseek. Buffered bytes are discarded.
+ *
+ * @param reader The reader to resume.
+ * @param checkpoint The position to resume from.
+ * @return TRUE on success, FALSE if the descriptor is not seekable or lseek fails.
+ */
+static inline bool stdi_reader_resume(stdi_reader_t *reader, const stdi_checkpoint_t *checkpoint)
+{
+    // Only untranscoded regular files can be resumed reliably
+    struct stat info;
+    if (reader->encoding != STDI_ENCODING_UTF8 || reader->ring != NULL
+        || fstat(reader->fd, &info) == -1 || !S_ISREG(info.st_mode))
+    {
+        return FALSE;
+    }
+
+    // Move the file position
+    if (lseek(reader->fd, checkpoint->offset, SEEK_SET) == -1)
+    {
+        return FALSE;
+    }
+
+    // Discard the buffered bytes
+    reader->start = 0;
+    reader->end = 0;
+    reader->generation++;
+    reader->base_offset = checkpoint->offset;
+    reader->line = checkpoint->line;
+    reader->line_start = checkpoint->line_start;
+    reader->last_line = checkpoint->line_start;
+    reader->eof = FALSE;
+    reader->error = FALSE;
+    return TRUE;
+}
+
+/**
+ * @brief Marks buffered bytes as consumed and updates the position counters.
+ *
+ * Newlines in the consumed range are counted with stdi_scan_newlines,
+ * so arbitrary byte ranges keep the line and column information accurate.
+ *
+ * @param reader The reader to advance.
+ * @param size The number of buffered bytes to consume.
+ */
+static inline void stdi_reader_advance(stdi_reader_t *reader, const size_t size)
+{
+    size_t last;
+    const size_t lines = stdi_scan_newlines(reader->buffer + reader->start, size, &last);
+
+    // Move the line start past the last consumed newline
+    if (lines > 0)
+    {
+        reader->line += lines;
+        reader->line_start = reader->base_offset + (off_t) (reader->start + last + 1);
+    }
+
+    reader->start += size;
+}
+
+/**
+ * @brief Reads up to `size` bytes from a reader into a caller-provided buffer.
+ *
+ * Buffered bytes are returned first. The position counters are updated
+ * for every byte that is handed out.
+ *
+ * @param reader The reader to read from.
+ * @param buffer A pointer to the buffer where the read data will be stored.
+ * @param size The maximum number of bytes to read.
+ * @return The number of bytes read, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_reader_read(stdi_reader_t *reader, char *buffer, const size_t size)
+{
+    // Refill if nothing is buffered
+    if (reader->start == reader->end)
+    {
+        if (reader->eof)
+        {
+            return 0;
+        }
+
+        const ssize_t bytes_read = stdi_reader_fill(reader);
+        if (bytes_read <= 0)
+        {
+            return bytes_read;
+        }
+    }
+
+    // Copy as many buffered bytes as possible
+    const size_t available = reader->end - reader->start;
+    const size_t count = available < size ? available : size;
+    memcpy(buffer, reader->buffer + reader->start, count);
+    stdi_reader_advance(reader, count);
+    return (ssize_t) count;
+}
+
+/**
+ * @brief Gathers byte statistics over a block in a single pass.
+ *
+ * When SSE2 is available, the block is classified 16 bytes at a time and
+ * the per-class bitmaps are counted with popcount.
+ *
+ * @param data A pointer to the data to scan.
+ * @param size The number of bytes to scan.
+ * @param stats Receives the statistics.
+ */
+static inline void stdi_scan_format_stats(const char *data, const size_t size, stdi_format_stats_t *stats)
+{
+    size_t i = 0;
+    size_t carriage_returns = 0;
+    memset(stats, 0, sizeof(*stats));
+
+#   if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i *) (data + i));
+
+        // Bytes <= 0x1F are the ones left unchanged by an unsigned min with 0x1F
+        const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(block, control), block);
+        const unsigned int nul = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+
+        stats->newlines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        stats->commas += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, comma)));
+        stats->tabs += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, tab)));
+        carriage_returns += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, carriage_return)));
+        stats->controls += __builtin_popcount(_mm_movemask_epi8(is_control));
+        stats->nul_even += __builtin_popcount(nul & 0x5555);
+        stats->nul_odd += __builtin_popcount(nul & 0xAAAA);
+    }
+#   endif
+
+    // Handle the remaining bytes
+    for (; i < size; i++)
+    {
+        const unsigned char c = (unsigned char) data[i];
+        stats->newlines += c == '\n';
+        stats->commas += c == ',';
+        stats->tabs += c == '\t';
+        carriage_returns += c == '\r';
+        stats->controls += c <= 0x1F;
+
+        if (c == 0)
+        {
+            if (i % 2 == 0)
+            {
+                stats->nul_even++;
+            }
+            else
+            {
+                stats->nul_odd++;
+            }
+        }
+    }
+
+    // Whitespace control bytes are expected in text
+    stats->controls -= stats->newlines + stats->tabs + carriage_returns;
+}
+
+/**
+ * @brief Checks if the complete lines of a block share the same non-zero delimiter count.
+ *
+ * Only the first few lines are checked, quoting is not taken into account.
+ *
+ * @param data A pointer to the data to check.
+ * @param size The number of bytes to check.
+ * @param delimiter The delimiter to count.
+ * @return TRUE if every checked line has the same number of delimiters.
+ */
+static inline bool stdi_detect_delimited(const char *data, const size_t size, const char delimiter)
+{
+    size_t expected = 0;
+    size_t checked = 0;
+    const char *line = data;
+    const char *end = data + size;
+
+    while (checked < 8)
+    {
+        const char *newline = memchr(line, '\n', end - line);
+        if (newline == NULL)
+        {
+            break;
+        }
+
+        // Count the delimiters in this line
+        size_t count = 0;
+        for (const char *c = line; c < newline; c++)
+        {
+            count += *c == delimiter;
+        }
+
+        if (count == 0 || (checked > 0 && count != expected))
+        {
+            return FALSE;
+        }
+
+        expected = count;
+        checked++;
+        line = newline + 1;
+    }
+
+    return checked > 0;
+}
+
+/**
+ * @brief Returns a view of up to `size` upcoming bytes without consuming them.
+ *
+ * If fewer than `size` bytes are buffered, the reader is refilled once (and
+ * its buffer grown if needed), so peeking never waits for more input than a
+ * single read returns. Call it again to look further ahead. The returned
+ * pointer refers to the reader's internal buffer and is only valid until the
+ * next call on the same reader. Use stdi_reader_consume to skip past the
+ * inspected bytes.
+ *
+ * @param reader The reader to peek into.
+ * @param size The number of bytes to look ahead.
+ * @param length Receives the number of bytes available, which may be less
+ *               than `size` before the end of input; it is 0 only at the
+ *               end of input.
+ * @return A pointer to the upcoming bytes, or NULL if an error occurs.
+ */
+static inline const char* stdi_peek(stdi_reader_t *reader, const size_t size, size_t *length)
+{
+    // Make sure the buffer can hold the requested bytes
+    if (reader->capacity < size)
+    {
+        STDI_PROBE2(realloc, reader->capacity, size);
+        char *new_buffer = realloc(reader->buffer, sizeof(char) * size);
+        if (new_buffer == NULL)
+        {
+            STDI_PROBE2(error, reader->fd, ENOMEM);
+            reader->error = TRUE;
+            return NULL;
+        }
+
+        reader->buffer = new_buffer;
+        reader->capacity = size;
+        reader->generation++;
+    }
+
+    // Read once if fewer bytes are buffered, making room for them first
+    if (reader->end - reader->start < size && !reader->eof)
+    {
+        if (reader->start + size > reader->capacity)
+        {
+            memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+            reader->base_offset += reader->start;
+            reader->end -= reader->start;
+            reader->start = 0;
+            reader->generation++;
+        }
+
+        if (stdi_reader_fill(reader) == -1)
+        {
+            return NULL;
+        }
+    }
+
+    const size_t available = reader->end - reader->start;
+    *length = available < size ? available : size;
+    return reader->buffer + reader->start;
+}
+
+/**
+ * @brief Consumes up to `size` buffered bytes, typically after stdi_peek.
+ *
+ * @param reader The reader to consume from.
+ * @param size The number of bytes to consume.
+ * @return The number of bytes actually consumed.
+ */
+static inline size_t stdi_reader_consume(stdi_reader_t *reader, const size_t size)
+{
+    const size_t available = reader->end - reader->start;
+    const size_t count = available < size ? available : size;
+    stdi_reader_advance(reader, count);
+    return count;
+}
+
+/**
+ * @brief Classifies the input of a reader by inspecting its first block.
+ *
+ * The block is obtained with stdi_peek, so nothing is consumed and the
+ * reader can be handed to the matching parser afterward. It holds up to
+ * STDI_DETECT_BLOCK_SIZE bytes but only what a single read returns, so
+ * sniffing a protocol on a pipe or socket does not wait for the peer to send
+ * a full block. Compressed data
+ * and byte order marks are recognized by their magic bytes, the remaining
+ * formats are told apart from byte statistics gathered in a single SIMD pass.
+ *
+ * @param reader The reader to inspect.
+ * @return The detected format, or STDI_FORMAT_ERROR if the first block
+ *         could not be read or buffered.
+ */
+static inline stdi_format_t stdi_detect_format(stdi_reader_t *reader)
+{
+    size_t size;
+    const unsigned char *data = (const unsigned char *) stdi_peek(reader, STDI_DETECT_BLOCK_SIZE, &size);
+
+    // Handle errors and empty input
+    if (data == NULL)
+    {
+        return STDI_FORMAT_ERROR;
+    }
+
+    if (size == 0)
+    {
+        return STDI_FORMAT_EMPTY;
+    }
+
+    // Check for magic numbers
+    if (size >= 2 && data[0] == 0x1F && data[1] == 0x8B)
+    {
+        return STDI_FORMAT_GZIP;
+    }
+
+    if (size >= 4 && data[0] == 0x28 && data[1] == 0xB5 && data[2] == 0x2F && data[3] == 0xFD)
+    {
+        return STDI_FORMAT_ZSTD;
+    }
+
+    // Check for byte order marks
+    if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF)
+    {
+        return STDI_FORMAT_UTF8_BOM;
+    }
+
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+    {
+        return STDI_FORMAT_UTF16LE;
+    }
+
+    if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF)
+    {
+        return STDI_FORMAT_UTF16BE;
+    }
+
+    stdi_format_stats_t stats;
+    stdi_scan_format_stats((const char *) data, size, &stats);
+
+    // UTF-16 text without a BOM has NUL bytes on one side of most code units
+    const size_t nul = stats.nul_even + stats.nul_odd;
+    if (nul > 0)
+    {
+        if (stats.nul_odd > size / 4 && stats.nul_even == 0)
+        {
+            return STDI_FORMAT_UTF16LE;
+        }
+
+        if (stats.nul_even > size / 4 && stats.nul_odd == 0)
+        {
+            return STDI_FORMAT_UTF16BE;
+        }
+
+        return STDI_FORMAT_BINARY;
+    }
+
+    // Text rarely contains control bytes
+    if (stats.controls > size / 100)
+    {
+        return STDI_FORMAT_BINARY;
+    }
+
+    // Find the first non-whitespace byte
+    size_t first = 0;
+    while (first < size && (data[first] == ' ' || data[first] == '\t' || data[first] == '\r' || data[first] == '\n'))
+    {
+        first++;
+    }
+
+    // Check for JSON values that end on the same line
+    if (first < size && (data[first] == '{' || data[first] == '['))
+    {
+        const unsigned char *newline = memchr(data + first, '\n', size - first);
+        const unsigned char *last = newline == NULL ? data + size - 1 : newline - 1;
+
+        // Skip trailing whitespace
+        while (last > data + first && (*last == '\r' || *last == ' ' || *last == '\t'))
+        {
+            last--;
+        }
+
+        if (*last == '}' || *last == ']')
+        {
+            return STDI_FORMAT_NDJSON;
+        }
+    }
+
+    // Check for delimited records
+    if (stats.tabs >= stats.newlines && stats.tabs > 0 && stdi_detect_delimited((const char *) data, size, '\t'))
+    {
+        return STDI_FORMAT_TSV;
+    }
+
+    if (stats.commas >= stats.newlines && stats.commas > 0 && stdi_detect_delimited((const char *) data, size, ','))
+    {
+        return STDI_FORMAT_CSV;
+    }
+
+    return STDI_FORMAT_TEXT;
+}
+
+/**
+ * @brief Gets the position of the next unconsumed byte.
+ *
+ * @param reader The reader to query.
+ * @param position Receives the position.
+ */
+static inline void stdi_reader_position(const stdi_reader_t *reader, stdi_position_t *position)
+{
+    position->offset = reader->base_offset + (off_t) reader->start;
+    position->line = reader->line + 1;
+    position->column = (size_t) (position->offset - reader->line_start) + 1;
+}
+
+/**
+ * @brief Gets the position of a byte inside the line last returned by stdi_reader_next_line.
+ *
+ * This is meant for diagnostics: parsers can report the exact line, column
+ * and offset of a token by passing a pointer into the line they are parsing.
+ *
+ * @param reader The reader the line was read from.
+ * @param pointer A pointer into the last returned line.
+ * @param position Receives the position.
+ */
+static inline void stdi_reader_position_at(
+    const stdi_reader_t *reader,
+    const char *pointer,
+    stdi_position_t *position
+)
+{
+    position->offset = reader->base_offset + (off_t) (pointer - reader->buffer);
+
+    // Check if the line was terminated by a consumed newline
+    if (reader->last_line != reader->line_start)
+    {
+        position->line = reader->line;
+        position->column = (size_t) (position->offset - reader->last_line) + 1;
+        return;
+    }
+
+    position->line = reader->line + 1;
+    position->column = (size_t) (position->offset - reader->line_start) + 1;
+}
+
+/**
+ * @brief A per-line transform used by stdi_pipeline_run.
+ *
+ * @param line A view of the line, without its newline. Only valid during the call.
+ * @param length The length of the line in bytes.
+ * @param output The writer the transformed output should go to.
+ * @param context The context pointer passed to stdi_pipeline_run.
+ * @return TRUE to keep going, FALSE to stop the pipeline.
+ */
+typedef bool (*stdi_transform_t)(const char *line, size_t length, stdi_writer_t *output, void *context);
+
+/**
+ * @brief Runs a line-oriented filter from a reader to a writer.
+ *
+ * Every line is handed to the transform as a zero-copy view into the
+ * reader's buffer. Output goes through the writer, which coalesces it into
+ * large writes and is flushed once the input ends.
+ *
+ * @param reader The reader to pull lines from.
+ * @param writer The writer to send output to.
+ * @param transform The transform to apply to every line.
+ * @param context An opaque pointer passed to the transform.
+ * @return TRUE if all input was processed and flushed, FALSE on error or when the transform stopped.
+ */
+static inline bool stdi_pipeline_run(
+    stdi_reader_t *reader,
+    stdi_writer_t *writer,
+    const stdi_transform_t transform,
+    void *context
+)
+{
+    size_t length;
+    const char *line;
+
+    while ((line = stdi_reader_next_line(reader, &length)) != NULL)
+    {
+        // Stop if the transform asks to or the output broke
+        if (!transform(line, length, writer, context) || writer->error)
+        {
+            stdi_writer_flush(writer);
+            return FALSE;
+        }
+    }
+
+    return stdi_writer_flush(writer) && !reader->error;
+}
+
+/**
+ * @brief Runs a line-oriented filter from stdin to stdout.
+ *
+ * The reader and writer use their default buffer sizes, and output is
+ * flushed whenever reading from stdin would block.
+ *
+ * @param transform The transform to apply to every line.
+ * @param context An opaque pointer passed to the transform.
+ * @return TRUE if all input was processed and flushed, FALSE otherwise.
+ */
+static inline bool stdi_filter(const stdi_transform_t transform, void *context)
+{
+    stdi_reader_t reader;
+    stdi_writer_t writer;
+
+    if (!stdi_reader_init(&reader, STDIN_FILENO, 0))
+    {
+        return FALSE;
+    }
+
+    if (!stdi_writer_init(&writer, STDOUT_FILENO, 0, STDI_FLUSH_BEFORE_READ))
+    {
+        stdi_reader_destroy(&reader);
+        return FALSE;
+    }
+
+    stdi_reader_tie(&reader, &writer);
+    const bool result = stdi_pipeline_run(&reader, &writer, transform, context);
+
+    stdi_writer_destroy(&writer);
+    stdi_reader_destroy(&reader);
+    return result;
+}
+
+/**
+ * @brief Lifecycle of a chunk in stdi_parallel_map.
+ */
+typedef enum
+{
+    STDI_CHUNK_FREE,    // Owned by the reading thread
+    STDI_CHUNK_READY,   // Waiting for a worker
+    STDI_CHUNK_DONE     // Transformed, waiting to be written in order
+} stdi_chunk_state_t;
+
+/**
+ * @brief A block of complete lines processed by one worker.
+ */
+typedef struct
+{
+    char *input;                // Copy of the input lines
+    size_t input_length;        // Number of input bytes
+    size_t input_capacity;      // Size of `input` in bytes
+    char *spill;                // Oversized input staged by the reading thread, or NULL
+    stdi_writer_t output;       // In-memory writer collecting the transformed lines
+    stdi_chunk_state_t state;   // Who owns the chunk
+    bool failed;                // Whether the transform stopped or output failed
+} stdi_parallel_chunk_t;
+
+/**
+ * @brief Tuning options for stdi_parallel_map_with_options.
+ */
+typedef struct
+{
+    size_t threads;     // Number of worker threads
+    bool pin_workers;   // Pin worker `i` to the `i`-th CPU the process may run on (Linux only)
+} stdi_parallel_options_t;
+
+/**
+ * @brief Shared state between the reading thread and the workers.
+ *
+ * Chunk `n` lives in slot `n % count` and is transformed by worker
+ * `n % workers`. The slots double as a bounded reorder buffer: a slot is
+ * only refilled after its previous chunk has been written out. Since
+ * `count` is a multiple of `workers`, every slot is only ever touched by
+ * the same worker, which allocates it itself so its pages are placed on
+ * that worker's NUMA node by first-touch.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;          // Protects the fields below and the chunk states
+    pthread_cond_t work_ready;      // Signaled when a chunk is submitted
+    pthread_cond_t work_done;       // Signaled when a chunk is transformed
+    stdi_parallel_chunk_t *chunks;  // The chunk slots
+    size_t count;                   // Number of chunk slots in use
+    size_t workers;                 // Number of running workers, 0 until all are started
+    size_t ready;                   // Number of workers that allocated their slots
+    size_t submitted;               // Number of chunks submitted so far
+    bool finished;                  // Whether no more chunks will be submitted
+    bool failed;                    // Whether a worker could not allocate its slots
+    bool pin_workers;               // Whether workers pin themselves to a CPU
+    stdi_transform_t transform;     // The transform to apply
+    void *context;                  // The context passed to the transform
+} stdi_parallel_t;
+
+/**
+ * @brief Per-worker arguments of stdi_parallel_worker.
+ */
+typedef struct
+{
+    stdi_parallel_t *parallel;  // The shared state
+    size_t index;               // Index of the worker
+} stdi_parallel_worker_t;
+
+/**
+ * @brief Pins the calling thread to the `index`-th CPU it is allowed to run on.
+ *
+ * @param index The index of the CPU among the allowed ones, wrapping around.
+ * @return TRUE on success, FALSE if pinning is not supported or fails.
+ */
+static inline bool stdi_pin_thread(const size_t index)
+{
+#   if defined(__linux__)
+    unsigned long allowed[16];
+    unsigned long pinned[16];
+    const size_t bits = sizeof(unsigned long) * 8;
+
+    // Get the CPUs we may run on
+    memset(allowed, 0, sizeof(allowed));
+    if (syscall(SYS_sched_getaffinity, 0, sizeof(allowed), allowed) == -1)
+    {
+        return FALSE;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < sizeof(allowed) * 8; i++)
+    {
+        total += (allowed[i / bits] >> (i % bits)) & 1;
+    }
+
+    if (total == 0)
+    {
+        return FALSE;
+    }
+
+    // Find the CPU to pin to
+    size_t target = index % total;
+    for (size_t i = 0; i < sizeof(allowed) * 8; i++)
+    {
+        if (((allowed[i / bits] >> (i % bits)) & 1) && target-- == 0)
+        {
+            memset(pinned, 0, sizeof(pinned));
+            pinned[i / bits] = 1UL << (i % bits);
+            return syscall(SYS_sched_setaffinity, 0, sizeof(pinned), pinned) == 0;
+        }
+    }
+
+    return FALSE;
+#   else
+    (void) index;
+    return FALSE;
+#   endif
+}
+
+/**
+ * @brief Applies the transform to every line of a chunk.
+ *
+ * @param parallel The shared state.
+ * @param chunk The chunk to transform.
+ */
+static inline void stdi_parallel_transform(stdi_parallel_t *parallel, stdi_parallel_chunk_t *chunk)
+{
+    chunk->output.length = 0;
+    chunk->failed = FALSE;
+
+    // Move oversized input into a buffer allocated here, so first-touch
+    // places it on this worker's node rather than the reading thread's
+    if (chunk->spill != NULL)
+    {
+        STDI_PROBE2(realloc, chunk->input_capacity, chunk->input_length);
+        free(chunk->input);
+        chunk->input = malloc(sizeof(char) * chunk->input_length);
+        chunk->input_capacity = chunk->input == NULL ? 0 : chunk->input_length;
+
+        if (chunk->input != NULL)
+        {
+            memcpy(chunk->input, chunk->spill, chunk->input_length);
+        }
+
+        free(chunk->spill);
+        chunk->spill = NULL;
+
+        if (chunk->input == NULL)
+        {
+            STDI_PROBE2(error, -1, ENOMEM);
+            chunk->failed = TRUE;
+            return;
+        }
+    }
+
+    const char *cursor = chunk->input;
+    const char *end = chunk->input + chunk->input_length;
+
+    while (cursor < end)
+    {
+        const char *newline = memchr(cursor, '\n', end - cursor);
+        const size_t length = newline == NULL ? (size_t) (end - cursor) : (size_t) (newline - cursor);
+
+        if (!parallel->transform(cursor, length, &chunk->output, parallel->context) || chunk->output.error)
+        {
+            chunk->failed = TRUE;
+            return;
+        }
+
+        cursor += length + 1;
+    }
+}
+
+/**
+ * @brief Allocates and touches the slots owned by a worker.
+ *
+ * @param parallel The shared state.
+ * @param index The index of the worker.
+ * @return TRUE on success, FALSE if an allocation failed.
+ */
+static inline bool stdi_parallel_allocate(stdi_parallel_t *parallel, const size_t index)
+{
+    for (size_t i = index; i < parallel->count; i += parallel->workers)
+    {
+        stdi_parallel_chunk_t *chunk = &parallel->chunks[i];
+
+        chunk->input = malloc(sizeof(char) * STDI_PARALLEL_CHUNK_SIZE);
+        if (chunk->input == NULL || !stdi_writer_init(&chunk->output, -1, 0, STDI_FLUSH_EXPLICIT))
+        {
+            return FALSE;
+        }
+
+        // Touch the pages so they are placed on this worker's node
+        memset(chunk->input, 0, STDI_PARALLEL_CHUNK_SIZE);
+        memset(chunk->output.buffer, 0, chunk->output.capacity);
+        chunk->input_capacity = STDI_PARALLEL_CHUNK_SIZE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Worker loop of stdi_parallel_map: transforms every `workers`-th chunk.
+ *
+ * @param argument The worker's stdi_parallel_worker_t.
+ * @return NULL.
+ */
+static inline void* stdi_parallel_worker(void *argument)
+{
+    const stdi_parallel_worker_t *worker = argument;
+    stdi_parallel_t *parallel = worker->parallel;
+
+    // Pin before allocating, so first-touch picks the right node
+    if (parallel->pin_workers)
+    {
+        stdi_pin_thread(worker->index);
+    }
+
+    // Wait until every worker is started
+    pthread_mutex_lock(&parallel->mutex);
+    while (parallel->workers == 0 && !parallel->finished)
+    {
+        pthread_cond_wait(&parallel->work_ready, &parallel->mutex);
+    }
+    pthread_mutex_unlock(&parallel->mutex);
+
+    const bool allocated = stdi_parallel_allocate(parallel, worker->index);
+
+    // Report that our slots are ready
+    pthread_mutex_lock(&parallel->mutex);
+    parallel->failed = parallel->failed || !allocated;
+    parallel->ready++;
+    pthread_cond_broadcast(&parallel->work_done);
+    pthread_mutex_unlock(&parallel->mutex);
+
+    for (size_t sequence = worker->index; TRUE; sequence += parallel->workers)
+    {
+        pthread_mutex_lock(&parallel->mutex);
+
+        // Wait for our next chunk or for the end of input
+        while (sequence >= parallel->submitted && !parallel->finished)
+        {
+            pthread_cond_wait(&parallel->work_ready, &parallel->mutex);
+        }
+
+        if (sequence >= parallel->submitted)
+        {
+            pthread_mutex_unlock(&parallel->mutex);
+            return NULL;
+        }
+
+        pthread_mutex_unlock(&parallel->mutex);
+
+        stdi_parallel_chunk_t *chunk = &parallel->chunks[sequence % parallel->count];
+        stdi_parallel_transform(parallel, chunk);
+
+        // Hand the chunk back to the reading thread
+        pthread_mutex_lock(&parallel->mutex);
+        chunk->state = STDI_CHUNK_DONE;
+        pthread_cond_broadcast(&parallel->work_done);
+        pthread_mutex_unlock(&parallel->mutex);
+    }
+}
+
+/**
+ * @brief Fills a chunk with the next block of complete lines from a reader.
+ *
+ * The block holds the buffered lines, up to STDI_PARALLEL_CHUNK_SIZE bytes.
+ * The reader is refilled one read at a time while more input is ready, but
+ * only waits for input while no complete line is buffered, so a slow
+ * producer's lines are handed out as they arrive.
+ *
+ * @param reader The reader to pull lines from.
+ * @param chunk The chunk to fill.
+ * @return TRUE if the chunk holds data, FALSE on end of input or error.
+ */
+static inline bool stdi_parallel_fill(stdi_reader_t *reader, stdi_parallel_chunk_t *chunk)
+{
+    size_t wanted = STDI_PARALLEL_CHUNK_SIZE;
+    const size_t buffered = reader->end - reader->start;
+    size_t length = buffered < wanted ? buffered : wanted;
+    const char *view = reader->buffer + reader->start;
+    size_t take;
+
+    while (TRUE)
+    {
+        // Cut the block after its last newline
+        take = length;
+        while (take > 0 && view[take - 1] != '\n')
+        {
+            take--;
+        }
+
+        // Stop at a complete line unless more input is ready right away
+        if (take > 0 && (reader->eof || length == wanted || stdi_reader_would_block(reader)))
+        {
+            break;
+        }
+
+        // Take everything at the end of input
+        if (take == 0 && reader->eof && length < wanted)
+        {
+            take = length;
+            break;
+        }
+
+        // Read once more, looking further only when a single line fills the view
+        if (take == 0 && length == wanted)
+        {
+            wanted *= 2;
+        }
+
+        view = stdi_peek(reader, wanted, &length);
+        if (view == NULL)
+        {
+            return FALSE;
+        }
+    }
+
+    if (take == 0)
+    {
+        return FALSE;
+    }
+
+    // Stage blocks that do not fit, the worker grows its own buffer for them
+    char *target = chunk->input;
+    if (chunk->input_capacity < take)
+    {
+        target = malloc(sizeof(char) * take);
+        if (target == NULL)
+        {
+            STDI_PROBE2(error, reader->fd, ENOMEM);
+            reader->error = TRUE;
+            return FALSE;
+        }
+
+        chunk->spill = target;
+    }
+
+    memcpy(target, view, take);
+    chunk->input_length = take;
+    stdi_reader_consume(reader, take);
+    return TRUE;
+}
+
+/**
+ * @brief Runs a line-oriented filter on several threads, keeping the output in input order.
+ *
+ * The input is split into blocks of complete lines (about
+ * STDI_PARALLEL_CHUNK_SIZE bytes each), which are transformed by a pool of
+ * worker threads into in-memory writers. Finished blocks are written to
+ * `writer` strictly in input order. At most STDI_PARALLEL_CHUNKS_PER_THREAD
+ * blocks per thread are in flight, which bounds the memory used for
+ * reordering.
+ *
+ * Blocks are dealt to the workers round-robin and every worker allocates
+ * the buffers of its own blocks, including the larger ones needed for
+ * overlong lines, so on NUMA machines they end up on the worker's node.
+ * Pinning the workers keeps them there.
+ *
+ * The transform is called concurrently from several threads, so it and its
+ * context must be thread-safe. Lines after one for which the transform
+ * returned FALSE may already have been transformed, but their output is
+ * discarded.
+ *
+ * @param reader The reader to pull lines from.
+ * @param writer The writer to send output to.
+ * @param transform The transform to apply to every line.
+ * @param context An opaque pointer passed to the transform.
+ * @param options The tuning options, fewer than 2 threads run stdi_pipeline_run instead.
+ * @return TRUE if all input was processed and flushed, FALSE on error or when the transform stopped.
+ */
+static inline bool stdi_parallel_map_with_options(
+    stdi_reader_t *reader,
+    stdi_writer_t *writer,
+    const stdi_transform_t transform,
+    void *context,
+    const stdi_parallel_options_t *options
+)
+{
+    const size_t threads = options->threads;
+    if (threads < 2)
+    {
+        return stdi_pipeline_run(reader, writer, transform, context);
+    }
+
+    stdi_parallel_t parallel;
+    parallel.count = 0;
+    parallel.workers = 0;
+    parallel.ready = 0;
+    parallel.submitted = 0;
+    parallel.finished = FALSE;
+    parallel.failed = FALSE;
+    parallel.pin_workers = options->pin_workers;
+    parallel.transform = transform;
+    parallel.context = context;
+
+    // Allocate the chunk slots, their buffers are allocated by the workers
+    parallel.chunks = calloc(threads * STDI_PARALLEL_CHUNKS_PER_THREAD, sizeof(stdi_parallel_chunk_t));
+    pthread_t *handles = malloc(sizeof(pthread_t) * threads);
+    stdi_parallel_worker_t *workers = malloc(sizeof(stdi_parallel_worker_t) * threads);
+    if (parallel.chunks == NULL || handles == NULL || workers == NULL)
+    {
+        free(parallel.chunks);
+        free(handles);
+        free(workers);
+        return FALSE;
+    }
+
+    pthread_mutex_init(&parallel.mutex, NULL);
+    pthread_cond_init(&parallel.work_ready, NULL);
+    pthread_cond_init(&parallel.work_done, NULL);
+
+    // Start the workers
+    size_t started = 0;
+    for (; started < threads; started++)
+    {
+        workers[started].parallel = &parallel;
+        workers[started].index = started;
+
+        if (pthread_create(&handles[started], NULL, stdi_parallel_worker, &workers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    // Let the workers allocate their slots
+    pthread_mutex_lock(&parallel.mutex);
+    parallel.count = started * STDI_PARALLEL_CHUNKS_PER_THREAD;
+    parallel.workers = started;
+    parallel.finished = started == 0;
+    pthread_cond_broadcast(&parallel.work_ready);
+
+    while (parallel.ready < started)
+    {
+        pthread_cond_wait(&parallel.work_done, &parallel.mutex);
+    }
+
+    const bool result = started > 0 && !parallel.failed;
+    pthread_mutex_unlock(&parallel.mutex);
+
+    size_t written = 0;
+    bool reading = result;
+    bool failed = FALSE;
+
+    while (TRUE)
+    {
+        // Drain the chunks in flight before waiting for input, so the output of
+        // a slow producer's lines is not held back until more input arrives
+        const bool idle = reading
+            && !reader->eof
+            && memchr(reader->buffer + reader->start, '\n', reader->end - reader->start) == NULL
+            && stdi_reader_would_block(reader);
+
+        // Write out finished chunks in order, waiting when every slot is in use
+        while (written < parallel.submitted)
+        {
+            stdi_parallel_chunk_t *chunk = &parallel.chunks[written % parallel.count];
+            const bool full = parallel.submitted - written == parallel.count;
+
+            pthread_mutex_lock(&parallel.mutex);
+            while ((full || !reading || idle) && chunk->state != STDI_CHUNK_DONE)
+            {
+                pthread_cond_wait(&parallel.work_done, &parallel.mutex);
+            }
+
+            const bool done = chunk->state == STDI_CHUNK_DONE;
+            pthread_mutex_unlock(&parallel.mutex);
+
+            if (!done)
+            {
+                break;
+            }
+
+            // Output after a failed chunk is discarded
+            if (!failed)
+            {
+                stdi_writer_write(writer, chunk->output.buffer, chunk->output.length);
+                failed = chunk->failed || writer->error;
+                reading = reading && !failed;
+            }
+
+            chunk->state = STDI_CHUNK_FREE;
+            written++;
+        }
+
+        if (!reading)
+        {
+            break;
+        }
+
+        // Submit the next chunk
+        stdi_parallel_chunk_t *chunk = &parallel.chunks[parallel.submitted % parallel.count];
+        if (!stdi_parallel_fill(reader, chunk))
+        {
+            reading = FALSE;
+            continue;
+        }
+
+        pthread_mutex_lock(&parallel.mutex);
+        chunk->state = STDI_CHUNK_READY;
+        parallel.submitted++;
+        pthread_cond_broadcast(&parallel.work_ready);
+        pthread_mutex_unlock(&parallel.mutex);
+    }
+
+    // Let the workers exit
+    pthread_mutex_lock(&parallel.mutex);
+    parallel.finished = TRUE;
+    pthread_cond_broadcast(&parallel.work_ready);
+    pthread_mutex_unlock(&parallel.mutex);
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(handles[i], NULL);
+    }
+
+    // Release everything
+    for (size_t i = 0; i < threads * STDI_PARALLEL_CHUNKS_PER_THREAD; i++)
+    {
+        if (parallel.chunks[i].output.buffer != NULL)
+        {
+            stdi_writer_destroy(&parallel.chunks[i].output);
+        }
+
+        free(parallel.chunks[i].input);
+        free(parallel.chunks[i].spill);
+    }
+
+    pthread_cond_destroy(&parallel.work_done);
+    pthread_cond_destroy(&parallel.work_ready);
+    pthread_mutex_destroy(&parallel.mutex);
+    free(parallel.chunks);
+    free(handles);
+    free(workers);
+
+    return stdi_writer_flush(writer) && result && !failed && !reader->error;
+}
+
+/**
+ * @brief Runs a line-oriented filter on several threads, keeping the output in input order.
+ *
+ * Same as stdi_parallel_map_with_options, without pinning the workers.
+ *
+ * @param reader The reader to pull lines from.
+ * @param writer The writer to send output to.
+ * @param transform The transform to apply to every line.
+ * @param context An opaque pointer passed to the transform.
+ * @param threads The number of worker threads, values below 2 run stdi_pipeline_run instead.
+ * @return TRUE if all input was processed and flushed, FALSE on error or when the transform stopped.
+ */
+static inline bool stdi_parallel_map(
+    stdi_reader_t *reader,
+    stdi_writer_t *writer,
+    const stdi_transform_t transform,
+    void *context,
+    const size_t threads
+)
+{
+    const stdi_parallel_options_t options = { threads, FALSE };
+    return stdi_parallel_map_with_options(reader, writer, transform, context, &options);
+}
+
+/**
+ * @brief Runs a line-oriented filter from stdin to stdout on several threads.
+ *
+ * Same as stdi_filter, but lines are transformed by stdi_parallel_map.
+ *
+ * @param transform The transform to apply to every line, must be thread-safe.
+ * @param context An opaque pointer passed to the transform.
+ * @param threads The number of worker threads.
+ * @return TRUE if all input was processed and flushed, FALSE otherwise.
+ */
+static inline bool stdi_parallel_filter(const stdi_transform_t transform, void *context, const size_t threads)
+{
+    stdi_reader_t reader;
+    stdi_writer_t writer;
+
+    if (!stdi_reader_init(&reader, STDIN_FILENO, 0))
+    {
+        return FALSE;
+    }
+
+    if (!stdi_writer_init(&writer, STDOUT_FILENO, 0, STDI_FLUSH_BEFORE_READ))
+    {
+        stdi_reader_destroy(&reader);
+        return FALSE;
+    }
+
+    stdi_reader_tie(&reader, &writer);
+    const bool result = stdi_parallel_map(&reader, &writer, transform, context, threads);
+
+    stdi_writer_destroy(&writer);
+    stdi_reader_destroy(&reader);
+    return result;
+}
+
+/**
+ * @brief Checks that all 8 bytes of a word are ASCII digits.
+ *
+ * @param word The bytes to check.
+ * @return TRUE if every byte is in '0'..'9'.
+ */
+static inline bool stdi_swar_all_digits(const uint64_t word)
+{
+    const uint64_t high = 0xF0F0F0F0F0F0F0F0ULL;
+    const uint64_t zeros = 0x3030303030303030ULL;
+
+    // The high nibble must be 3 and adding 6 must not overflow the low nibble
+    return (word & high) == zeros && ((word + 0x0606060606060606ULL) & high) == zeros;
+}
+
+/**
+ * @brief Checks the separators of an 8-byte block against a template and validates its digits.
+ *
+ * Template bytes other than '0' are separators that must match exactly,
+ * '0' bytes must be digits in the input.
+ *
+ * @param data The 8 input bytes.
+ * @param pattern The 8-byte template, e.g. "0000-00-".
+ * @return TRUE if the block matches the template.
+ */
+static inline bool stdi_swar_match(const char *data, const char *pattern)
+{
+    uint64_t word;
+    uint64_t expected;
+    memcpy(&word, data, sizeof(word));
+    memcpy(&expected, pattern, sizeof(expected));
+
+    // Build a mask of the separator bytes
+    const uint64_t digits = expected ^ 0x3030303030303030ULL;
+    uint64_t separators = digits | (digits >> 4);
+    separators |= separators >> 2;
+    separators |= separators >> 1;
+    separators = (separators & 0x0101010101010101ULL) * 0xFF;
+
+    // Separators must match, everything else must be a digit
+    return (word & separators) == (expected & separators)
+        && stdi_swar_all_digits((word & ~separators) | (0x3030303030303030ULL & separators));
+}
+
+/**
+ * @brief Converts a civil date to days since 1970-01-01.
+ *
+ * @param year The year.
+ * @param month The month (1-12).
+ * @param day The day of the month (1-31).
+ * @return The number of days since the Unix epoch.
+ */
+static inline int64_t stdi_days_from_civil(int64_t year, const unsigned int month, const unsigned int day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned int year_of_era = (unsigned int) (year - era * 400);
+    const unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + (int64_t) day_of_era - 719468;
+}
+
+/**
+ * @brief Parses an ISO-8601 / RFC 3339 timestamp into nanoseconds since the Unix epoch.
+ *
+ * Accepted format: `YYYY-MM-DD(T|t| )HH:MM:SS[.fraction][Z|z|(+|-)HH[:]MM]`.
+ * A missing offset means UTC. Fractions longer than 9 digits are truncated.
+ * The fixed-width part is validated 8 bytes at a time with SWAR checks, and
+ * every field is range-checked (including the day of the month).
+ *
+ * @param data The bytes to parse, e.g. a line view from the reader.
+ * @param length The number of bytes available.
+ * @param nanoseconds Receives the timestamp in nanoseconds since the Unix epoch.
+ * @param consumed Receives the number of bytes that made up the timestamp, may be NULL.
+ * @return TRUE on success, FALSE if the bytes are not a valid timestamp.
+ */
+static inline bool stdi_parse_timestamp(
+    const char *data,
+    const size_t length,
+    int64_t *nanoseconds,
+    size_t *consumed
+)
+{
+    if (length < 19)
+    {
+        return FALSE;
+    }
+
+    // Accept every date/time separator as 'T'
+    char time[8];
+    memcpy(time, data + 8, sizeof(time));
+    if (time[2] == 't' || time[2] == ' ')
+    {
+        time[2] = 'T';
+    }
+
+    // Check the fixed-width part
+    if (!stdi_swar_match(data, "0000-00-")
+        || !stdi_swar_match(time, "00T00:00")
+        || data[16] != ':'
+        || (unsigned char) (data[17] - '0') > 9
+        || (unsigned char) (data[18] - '0') > 9)
+    {
+        return FALSE;
+    }
+
+#   define STDI_DIGIT(index) ((unsigned int) (data[index] - '0'))
+    const unsigned int year = STDI_DIGIT(0) * 1000 + STDI_DIGIT(1) * 100 + STDI_DIGIT(2) * 10 + STDI_DIGIT(3);
+    const unsigned int month = STDI_DIGIT(5) * 10 + STDI_DIGIT(6);
+    const unsigned int day = STDI_DIGIT(8) * 10 + STDI_DIGIT(9);
+    const unsigned int hour = STDI_DIGIT(11) * 10 + STDI_DIGIT(12);
+    const unsigned int minute = STDI_DIGIT(14) * 10 + STDI_DIGIT(15);
+    const unsigned int second = STDI_DIGIT(17) * 10 + STDI_DIGIT(18);
+
+    // Validate the ranges, 60 is allowed for leap seconds
+    static const unsigned char days_in_month[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month[month - 1]
+        || (month == 2 && day == 29 && !leap)
+        || hour > 23 || minute > 59 || second > 60)
+    {
+        return FALSE;
+    }
+
+    size_t position = 19;
+    int64_t fraction = 0;
+
+    // Parse the fraction
+    if (position < length && data[position] == '.')
+    {
+        position++;
+        const size_t start = position;
+        int64_t scale = 1000000000;
+
+        while (position < length && (unsigned char) (data[position] - '0') <= 9)
+        {
+            if (scale > 1)
+            {
+                scale /= 10;
+                fraction += STDI_DIGIT(position) * scale;
+            }
+
+            position++;
+        }
+
+        if (position == start)
+        {
+            return FALSE;
+        }
+    }
+
+    int64_t offset = 0;
+
+    // Parse the offset
+    if (position < length && (data[position] == 'Z' || data[position] == 'z'))
+    {
+        position++;
+    }
+    else if (position < length && (data[position] == '+' || data[position] == '-'))
+    {
+        const bool negative = data[position] == '-';
+        const bool colon = position + 3 < length && data[position + 3] == ':';
+        const size_t end = position + (colon ? 6 : 5);
+
+        if (end > length
+            || (unsigned char) (data[position + 1] - '0') > 9
+            || (unsigned char) (data[position + 2] - '0') > 9
+            || (unsigned char) (data[end - 2] - '0') > 9
+            || (unsigned char) (data[end - 1] - '0') > 9)
+        {
+            return FALSE;
+        }
+
+        const unsigned int offset_hours = STDI_DIGIT(position + 1) * 10 + STDI_DIGIT(position + 2);
+        const unsigned int offset_minutes = STDI_DIGIT(end - 2) * 10 + STDI_DIGIT(end - 1);
+        if (offset_hours > 23 || offset_minutes > 59)
+        {
+            return FALSE;
+        }
+
+        offset = ((int64_t) offset_hours * 60 + offset_minutes) * 60;
+        offset = negative ? -offset : offset;
+        position = end;
+    }
+#   undef STDI_DIGIT
+
+    const int64_t seconds = stdi_days_from_civil(year, month, day) * 86400
+        + (int64_t) hour * 3600 + (int64_t) minute * 60 + second - offset;
+
+    // Make sure the result fits in 64-bit nanoseconds (years 1677 to 2262)
+    if (seconds > INT64_MAX / 1000000000 - 1 || seconds < INT64_MIN / 1000000000 + 1)
+    {
+        return FALSE;
+    }
+
+    *nanoseconds = seconds * 1000000000 + fraction;
+    if (consumed != NULL)
+    {
+        *consumed = position;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief A non-owning view of a run of bytes.
+ */
+typedef struct
+{
+    const char *data;   // The first byte
+    size_t length;      // The number of bytes
+} stdi_view_t;
+
+/**
+ * @brief Iterator over the `key=value` pairs of a logfmt line.
+ */
+typedef struct
+{
+    const char *cursor; // Next byte to parse
+    const char *end;    // One past the last byte of the line
+} stdi_logfmt_t;
+
+/**
+ * @brief Starts iterating over the pairs of a logfmt line.
+ *
+ * @param iterator The iterator to initialize.
+ * @param line The line, e.g. a view from the reader.
+ * @param length The length of the line in bytes.
+ */
+static inline void stdi_logfmt_init(stdi_logfmt_t *iterator, const char *line, const size_t length)
+{
+    iterator->cursor = line;
+    iterator->end = line + length;
+}
+
+/**
+ * @brief Gets the next pair of a logfmt line.
+ *
+ * Values can be bare (`key=value`), quoted (`key="a b"`) or missing
+ * (`key` or `key=`), in which case they are empty. Quoted values are
+ * returned without their quotes; escape sequences are left as-is, so
+ * `escaped` reports whether the value contains any backslash.
+ *
+ * @param iterator The iterator to advance.
+ * @param key Receives the key.
+ * @param value Receives the value.
+ * @param escaped Receives whether the value contains escape sequences, may be NULL.
+ * @return TRUE if a pair was read, FALSE at the end of the line.
+ */
+static inline bool stdi_logfmt_next(stdi_logfmt_t *iterator, stdi_view_t *key, stdi_view_t *value, bool *escaped)
+{
+    const char *cursor = iterator->cursor;
+    const char *end = iterator->end;
+
+    // Skip whitespace
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+    {
+        cursor++;
+    }
+
+    if (cursor == end)
+    {
+        iterator->cursor = cursor;
+        return FALSE;
+    }
+
+    // Read the key
+    key->data = cursor;
+    while (cursor < end && *cursor != '=' && *cursor != ' ' && *cursor != '\t')
+    {
+        cursor++;
+    }
+
+    key->length = cursor - key->data;
+    value->data = cursor;
+    value->length = 0;
+    bool has_escapes = FALSE;
+
+    if (cursor < end && *cursor == '=')
+    {
+        cursor++;
+
+        if (cursor < end && *cursor == '"')
+        {
+            // Read a quoted value
+            cursor++;
+            value->data = cursor;
+            while (cursor < end && *cursor != '"')
+            {
+                if (*cursor == '\\' && cursor + 1 < end)
+                {
+                    has_escapes = TRUE;
+                    cursor++;
+                }
+
+                cursor++;
+            }
+
+            value->length = cursor - value->data;
+
+            // Skip the closing quote
+            if (cursor < end)
+            {
+                cursor++;
+            }
+        }
+        else
+        {
+            // Read a bare value
+            value->data = cursor;
+            while (cursor < end && *cursor != ' ' && *cursor != '\t')
+            {
+                cursor++;
+            }
+
+            value->length = cursor - value->data;
+        }
+    }
+
+    if (escaped != NULL)
+    {
+        *escaped = has_escapes;
+    }
+
+    iterator->cursor = cursor;
+    return TRUE;
+}
+
+/**
+ * @brief Splits the next space-delimited token off a line.
+ *
+ * @param cursor The position to start at, advanced past the token and one space.
+ * @param end One past the last byte of the line.
+ * @param token Receives the token.
+ * @return TRUE if a non-empty token was found.
+ */
+static inline bool stdi_next_token(const char **cursor, const char *end, stdi_view_t *token)
+{
+    const char *start = *cursor;
+    if (start >= end)
+    {
+        return FALSE;
+    }
+
+    const char *space = memchr(start, ' ', end - start);
+    const char *stop = space == NULL ? end : space;
+
+    token->data = start;
+    token->length = stop - start;
+    *cursor = space == NULL ? end : space + 1;
+    return token->length > 0;
+}
+
+/**
+ * @brief The fields of an RFC 5424 syslog message.
+ *
+ * Fields holding the NILVALUE (`-`) are returned as empty views.
+ */
+typedef struct
+{
+    unsigned int facility;          // Facility (PRI / 8)
+    unsigned int severity;          // Severity (PRI % 8)
+    unsigned int version;           // Protocol version
+    stdi_view_t timestamp;          // RFC 3339 timestamp, see stdi_parse_timestamp
+    stdi_view_t hostname;           // Originating host
+    stdi_view_t app_name;           // Originating application
+    stdi_view_t proc_id;            // Process ID
+    stdi_view_t msg_id;             // Message type
+    stdi_view_t structured_data;    // All SD-ELEMENTs, including their brackets
+    stdi_view_t message;            // Free-form message
+} stdi_syslog_t;
+
+/**
+ * @brief Parses an RFC 5424 syslog line into field views.
+ *
+ * @param line The line, e.g. a view from the reader.
+ * @param length The length of the line in bytes.
+ * @param syslog Receives the fields, pointing into `line`.
+ * @return TRUE on success, FALSE if the line is not a valid RFC 5424 message.
+ */
+static inline bool stdi_parse_syslog(const char *line, const size_t length, stdi_syslog_t *syslog)
+{
+    const char *cursor = line;
+    const char *end = line + length;
+
+    // Parse the PRI part
+    if (cursor == end || *cursor != '<')
+    {
+        return FALSE;
+    }
+
+    cursor++;
+    unsigned int priority = 0;
+    const char *digits = cursor;
+    while (cursor < end && (unsigned char) (*cursor - '0') <= 9 && cursor - digits < 3)
+    {
+        priority = priority * 10 + (*cursor - '0');
+        cursor++;
+    }
+
+    if (cursor == digits || cursor == end || *cursor != '>' || priority > 191)
+    {
+        return FALSE;
+    }
+
+    cursor++;
+    syslog->facility = priority / 8;
+    syslog->severity = priority % 8;
+
+    // Parse the version
+    syslog->version = 0;
+    digits = cursor;
+    while (cursor < end && (unsigned char) (*cursor - '0') <= 9 && cursor - digits < 3)
+    {
+        syslog->version = syslog->version * 10 + (*cursor - '0');
+        cursor++;
+    }
+
+    if (cursor == digits || cursor == end || *cursor != ' ')
+    {
+        return FALSE;
+    }
+
+    cursor++;
+
+    // Parse the header fields
+    stdi_view_t *fields[5] = {
+        &syslog->timestamp,
+        &syslog->hostname,
+        &syslog->app_name,
+        &syslog->proc_id,
+        &syslog->msg_id
+    };
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        if (!stdi_next_token(&cursor, end, fields[i]))
+        {
+            return FALSE;
+        }
+
+        // Map the NILVALUE to an empty view
+        if (fields[i]->length == 1 && fields[i]->data[0] == '-')
+        {
+            fields[i]->length = 0;
+        }
+    }
+
+    // Parse the structured data
+    syslog->structured_data.data = cursor;
+    if (cursor < end && *cursor == '-')
+    {
+        syslog->structured_data.length = 0;
+        cursor++;
+    }
+    else
+    {
+        while (cursor < end && *cursor == '[')
+        {
+            // Find the closing bracket, skipping quoted parameter values
+            bool quoted = FALSE;
+            cursor++;
+            while (cursor < end && (quoted || *cursor != ']'))
+            {
+                if (*cursor == '\\' && cursor + 1 < end)
+                {
+                    cursor++;
+                }
+                else if (*cursor == '"')
+                {
+                    quoted = !quoted;
+                }
+
+                cursor++;
+            }
+
+            if (cursor == end)
+            {
+                return FALSE;
+            }
+
+            cursor++;
+        }
+
+        syslog->structured_data.length = cursor - syslog->structured_data.data;
+        if (syslog->structured_data.length == 0)
+        {
+            return FALSE;
+        }
+    }
+
+    // The message is optional
+    if (cursor < end && *cursor != ' ')
+    {
+        return FALSE;
+    }
+
+    syslog->message.data = cursor < end ? cursor + 1 : end;
+    syslog->message.length = end - syslog->message.data;
+    return TRUE;
+}
+
+/**
+ * @brief The fields of a Common or Combined Log Format line (Apache/Nginx access logs).
+ *
+ * Fields holding `-` are returned as empty views.
+ */
+typedef struct
+{
+    stdi_view_t host;       // Remote host
+    stdi_view_t ident;      // RFC 1413 identity
+    stdi_view_t user;       // Authenticated user
+    stdi_view_t time;       // Time without brackets, e.g. `10/Oct/2000:13:55:36 -0700`
+    stdi_view_t request;    // Request line without quotes
+    stdi_view_t method;     // Method part of the request line
+    stdi_view_t path;       // Path part of the request line
+    stdi_view_t protocol;   // Protocol part of the request line
+    unsigned int status;    // HTTP status code
+    int64_t bytes;          // Response size, -1 for `-`
+    stdi_view_t referer;    // Referer without quotes (Combined format only)
+    stdi_view_t user_agent; // User agent without quotes (Combined format only)
+} stdi_access_log_t;
+
+/**
+ * @brief Splits a quoted field off an access log line.
+ *
+ * @param cursor The position of the opening quote, advanced past the closing quote and one space.
+ * @param end One past the last byte of the line.
+ * @param field Receives the field without its quotes.
+ * @return TRUE on success, FALSE if the field is not quoted or not terminated.
+ */
+static inline bool stdi_next_quoted(const char **cursor, const char *end, stdi_view_t *field)
+{
+    const char *position = *cursor;
+    if (position >= end || *position != '"')
+    {
+        return FALSE;
+    }
+
+    position++;
+    field->data = position;
+
+    // Find the closing quote, skipping escaped ones
+    while (position < end && *position != '"')
+    {
+        if (*position == '\\' && position + 1 < end)
+        {
+            position++;
+        }
+
+        position++;
+    }
+
+    if (position == end)
+    {
+        return FALSE;
+    }
+
+    field->length = position - field->data;
+    position++;
+    *cursor = position < end && *position == ' ' ? position + 1 : position;
+    return TRUE;
+}
+
+/**
+ * @brief Parses a Common or Combined Log Format line into field views.
+ *
+ * @param line The line, e.g. a view from the reader.
+ * @param length The length of the line in bytes.
+ * @param log Receives the fields, pointing into `line`.
+ * @return TRUE on success, FALSE if the line is malformed.
+ */
+static inline bool stdi_parse_access_log(const char *line, const size_t length, stdi_access_log_t *log)
+{
+    const char *cursor = line;
+    const char *end = line + length;
+
+    // Parse the host, identity and user
+    stdi_view_t *fields[3] = { &log->host, &log->ident, &log->user };
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (!stdi_next_token(&cursor, end, fields[i]))
+        {
+            return FALSE;
+        }
+
+        if (fields[i]->length == 1 && fields[i]->data[0] == '-')
+        {
+            fields[i]->length = 0;
+        }
+    }
+
+    // Parse the bracketed time
+    if (cursor >= end || *cursor != '[')
+    {
+        return FALSE;
+    }
+
+    const char *close = memchr(cursor, ']', end - cursor);
+    if (close == NULL || close + 1 >= end || close[1] != ' ')
+    {
+        return FALSE;
+    }
+
+    log->time.data = cursor + 1;
+    log->time.length = close - cursor - 1;
+    cursor = close + 2;
+
+    // Parse the request line
+    if (!stdi_next_quoted(&cursor, end, &log->request))
+    {
+        return FALSE;
+    }
+
+    const char *request = log->request.data;
+    const char *request_end = request + log->request.length;
+    log->method.length = 0;
+    log->path.length = 0;
+    log->protocol.length = 0;
+    log->method.data = log->path.data = log->protocol.data = request;
+    stdi_next_token(&request, request_end, &log->method);
+    stdi_next_token(&request, request_end, &log->path);
+    stdi_next_token(&request, request_end, &log->protocol);
+
+    // Parse the status
+    stdi_view_t token;
+    if (!stdi_next_token(&cursor, end, &token) || token.length != 3)
+    {
+        return FALSE;
+    }
+
+    log->status = 0;
+    for (size_t i = 0; i < 3; i++)
+    {
+        if ((unsigned char) (token.data[i] - '0') > 9)
+        {
+            return FALSE;
+        }
+
+        log->status = log->status * 10 + (token.data[i] - '0');
+    }
+
+    // Parse the size
+    if (!stdi_next_token(&cursor, end, &token))
+    {
+        return FALSE;
+    }
+
+    if (token.length == 1 && token.data[0] == '-')
+    {
+        log->bytes = -1;
+    }
+    else
+    {
+        log->bytes = 0;
+        for (size_t i = 0; i < token.length; i++)
+        {
+            if ((unsigned char) (token.data[i] - '0') > 9 || i >= 18)
+            {
+                return FALSE;
+            }
+
+            log->bytes = log->bytes * 10 + (token.data[i] - '0');
+        }
+    }
+
+    // The Combined format adds the referer and user agent
+    log->referer.data = log->user_agent.data = end;
+    log->referer.length = log->user_agent.length = 0;
+    if (cursor < end)
+    {
+        if (!stdi_next_quoted(&cursor, end, &log->referer)
+            || !stdi_next_quoted(&cursor, end, &log->user_agent))
+        {
+            return FALSE;
+        }
+
+        if (log->referer.length == 1 && log->referer.data[0] == '-')
+        {
+            log->referer.length = 0;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Value types supported by stdi_kv_schema_t fields.
+ */
+typedef enum
+{
+    STDI_KV_VIEW,   // Stored as a stdi_view_t
+    STDI_KV_INT64,  // Stored as an int64_t, parsed from a decimal value
+    STDI_KV_BOOL    // Stored as a bool, parsed from true/false/1/0
+} stdi_kv_type_t;
+
+/**
+ * @brief Describes where the value of an expected key is stored.
+ */
+typedef struct
+{
+    const char *name;       // The key
+    stdi_kv_type_t type;    // How the value is parsed
+    size_t offset;          // Offset of the value in the target struct, see offsetof
+} stdi_kv_field_t;
+
+/**
+ * @brief A set of expected keys compiled into a perfect hash.
+ *
+ * Every key maps to its own slot, so dispatching a parsed key costs one
+ * hash, one table lookup and a single comparison against the key stored
+ * in that slot. The stored hash and length reject most unknown keys
+ * before the bytes are compared.
+ */
+typedef struct
+{
+    const stdi_kv_field_t *fields;  // The expected keys, at most 64
+    size_t count;                   // Number of expected keys
+    uint64_t seed;                  // Seed making the hash collision-free
+    size_t mask;                    // Table size minus one
+    uint8_t *table;                 // Slot -> field index + 1, 0 marks an empty slot
+    uint64_t *hashes;               // Hash of every key
+    size_t *lengths;                // Length of every key
+} stdi_kv_schema_t;
+
+/**
+ * @brief Compiles a set of expected keys into a perfect hash.
+ *
+ * @param schema The schema to initialize.
+ * @param fields The expected keys, must outlive the schema.
+ * @param count The number of keys, at most 64.
+ * @return TRUE on success, FALSE on duplicate keys, too many keys or allocation failure.
+ */
+static inline bool stdi_kv_schema_init(stdi_kv_schema_t *schema, const stdi_kv_field_t *fields, const size_t count)
+{
+    if (count == 0 || count > 64)
+    {
+        return FALSE;
+    }
+
+    schema->fields = fields;
+    schema->count = count;
+    schema->hashes = malloc(sizeof(uint64_t) * count);
+    schema->lengths = malloc(sizeof(size_t) * count);
+    schema->table = NULL;
+
+    if (schema->hashes == NULL || schema->lengths == NULL)
+    {
+        free(schema->hashes);
+        free(schema->lengths);
+        return FALSE;
+    }
+
+    // Reject duplicate keys, they can never be separated
+    for (size_t i = 0; i < count; i++)
+    {
+        schema->lengths[i] = strlen(fields[i].name);
+        for (size_t j = 0; j < i; j++)
+        {
+            if (schema->lengths[i] == schema->lengths[j] && memcmp(fields[i].name, fields[j].name, schema->lengths[i]) == 0)
+            {
+                free(schema->hashes);
+                free(schema->lengths);
+                return FALSE;
+            }
+        }
+    }
+
+    // Start with a table at least twice as large as the key set
+    size_t size = 4;
+    while (size < count * 2)
+    {
+        size *= 2;
+    }
+
+    while (TRUE)
+    {
+        uint8_t *table = malloc(size);
+        if (table == NULL)
+        {
+            free(schema->hashes);
+            free(schema->lengths);
+            return FALSE;
+        }
+
+        // Search for a seed that places every key in its own slot
+        for (uint64_t seed = 1; seed <= 256; seed++)
+        {
+            bool collision = FALSE;
+            memset(table, 0, size);
+
+            for (size_t i = 0; i < count && !collision; i++)
+            {
+                const uint64_t hash = stdi_hash(fields[i].name, schema->lengths[i], seed);
+                const size_t slot = hash & (size - 1);
+
+                collision = table[slot] != 0;
+                table[slot] = (uint8_t) (i + 1);
+                schema->hashes[i] = hash;
+            }
+
+            if (!collision)
+            {
+                schema->seed = seed;
+                schema->mask = size - 1;
+                schema->table = table;
+                return TRUE;
+            }
+        }
+
+        // Retry with a sparser table
+        free(table);
+        size *= 2;
+    }
+}
+
+/**
+ * @brief Releases the tables held by a schema.
+ *
+ * @param schema The schema to destroy.
+ */
+static inline void stdi_kv_schema_destroy(stdi_kv_schema_t *schema)
+{
+    free(schema->table);
+    free(schema->hashes);
+    free(schema->lengths);
+    schema->table = NULL;
+    schema->hashes = NULL;
+    schema->lengths = NULL;
+}
+
+/**
+ * @brief Parses a decimal integer view.
+ *
+ * @param value The view to parse.
+ * @param result Receives the integer.
+ * @return TRUE on success, FALSE if the view is not a decimal integer that fits in 64 bits.
+ */
+static inline bool stdi_parse_int64(const stdi_view_t *value, int64_t *result)
+{
+    const char *cursor = value->data;
+    const char *end = value->data + value->length;
+    const bool negative = cursor < end && *cursor == '-';
+    cursor += negative || (cursor < end && *cursor == '+');
+
+    if (cursor == end)
+    {
+        return FALSE;
+    }
+
+    uint64_t magnitude = 0;
+    for (; cursor < end; cursor++)
+    {
+        const unsigned int digit = (unsigned char) (*cursor - '0');
+        if (digit > 9 || magnitude > (UINT64_MAX - digit) / 10)
+        {
+            return FALSE;
+        }
+
+        magnitude = magnitude * 10 + digit;
+    }
+
+    // Check that the magnitude fits
+    if (magnitude > (uint64_t) INT64_MAX + negative)
+    {
+        return FALSE;
+    }
+
+    *result = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+    return TRUE;
+}
+
+/**
+ * @brief Parses a `key=value` line into a struct, dispatching keys through a schema.
+ *
+ * The line is split like logfmt (see stdi_logfmt_next). Unknown keys and
+ * values that do not parse as the field's type are skipped. View values
+ * point into `line`.
+ *
+ * @param schema The compiled set of expected keys.
+ * @param line The line, e.g. a view from the reader.
+ * @param length The length of the line in bytes.
+ * @param target The struct the values are written to.
+ * @return A bitmask of the fields that were written (bit `i` for `fields[i]`).
+ */
+static inline uint64_t stdi_kv_parse(const stdi_kv_schema_t *schema, const char *line, const size_t length, void *target)
+{
+    uint64_t written = 0;
+    stdi_logfmt_t iterator;
+    stdi_view_t key;
+    stdi_view_t value;
+
+    stdi_logfmt_init(&iterator, line, length);
+    while (stdi_logfmt_next(&iterator, &key, &value, NULL))
+    {
+        // Look the key up in the perfect hash
+        const uint64_t hash = stdi_hash(key.data, key.length, schema->seed);
+        const uint8_t entry = schema->table[hash & schema->mask];
+        if (entry == 0 || schema->hashes[entry - 1] != hash || schema->lengths[entry - 1] != key.length)
+        {
+            continue;
+        }
+
+        // Compare the bytes, hashes can be made to collide on purpose
+        const size_t index = entry - 1;
+        const stdi_kv_field_t *field = &schema->fields[index];
+        if (memcmp(key.data, field->name, key.length) != 0)
+        {
+            continue;
+        }
+        char *destination = (char *) target + field->offset;
+
+        switch (field->type)
+        {
+            case STDI_KV_VIEW:
+            {
+                memcpy(destination, &value, sizeof(value));
+                break;
+            }
+
+            case STDI_KV_INT64:
+            {
+                int64_t number;
+                if (!stdi_parse_int64(&value, &number))
+                {
+                    continue;
+                }
+
+                memcpy(destination, &number, sizeof(number));
+                break;
+            }
+
+            case STDI_KV_BOOL:
+            {
+                bool flag;
+                if ((value.length == 4 && memcmp(value.data, "true", 4) == 0)
+                    || (value.length == 1 && value.data[0] == '1'))
+                {
+                    flag = TRUE;
+                }
+                else if ((value.length == 5 && memcmp(value.data, "false", 5) == 0)
+                    || (value.length == 1 && value.data[0] == '0'))
+                {
+                    flag = FALSE;
+                }
+                else
+                {
+                    continue;
+                }
+
+                memcpy(destination, &flag, sizeof(flag));
+                break;
+            }
+        }
+
+        written |= (uint64_t) 1 << index;
+    }
+
+    return written;
+}
+
+/**
+ * @brief Kinds of tokens produced by stdi_json_next.
+ */
+typedef enum
+{
+    STDI_JSON_BEGIN_OBJECT, // `{`
+    STDI_JSON_END_OBJECT,   // `}`
+    STDI_JSON_BEGIN_ARRAY,  // `[`
+    STDI_JSON_END_ARRAY,    // `]`
+    STDI_JSON_KEY,          // An object key, the value holds the raw string
+    STDI_JSON_STRING,       // A string value, the value holds the raw string
+    STDI_JSON_NUMBER,       // A number, the value holds its text
+    STDI_JSON_TRUE,         // `true`
+    STDI_JSON_FALSE,        // `false`
+    STDI_JSON_NULL,         // `null`
+    STDI_JSON_END,          // End of input after complete documents
+    STDI_JSON_ERROR         // Malformed input, truncated input or read error
+} stdi_json_token_type_t;
+
+/**
+ * @brief A token produced by stdi_json_next.
+ *
+ * String and number values are views into the reader's buffer, valid
+ * until the next call on the tokenizer. Strings are returned without their
+ * quotes and with escape sequences untouched, see stdi_json_unescape.
+ */
+typedef struct
+{
+    stdi_json_token_type_t type;    // The kind of token
+    stdi_view_t value;              // Raw bytes of keys, strings and numbers
+    bool escaped;                   // Whether a key or string contains escape sequences
+    size_t depth;                   // Nesting depth of the token, top-level values are at 0
+} stdi_json_token_t;
+
+/**
+ * @brief What the tokenizer expects next.
+ */
+typedef enum
+{
+    STDI_JSON_EXPECT_VALUE,             // A value (or the end of input between documents)
+    STDI_JSON_EXPECT_VALUE_OR_END,      // A value or `]`, right after `[`
+    STDI_JSON_EXPECT_KEY,               // A key, after `,` in an object
+    STDI_JSON_EXPECT_KEY_OR_END,        // A key or `}`, right after `{`
+    STDI_JSON_EXPECT_COLON,             // `:` after a key
+    STDI_JSON_EXPECT_COMMA_OR_END,      // `,` or the end of the current container
+    STDI_JSON_FAILED                    // An error occurred
+} stdi_json_state_t;
+
+/**
+ * @brief A pull-based streaming JSON tokenizer over a reader.
+ *
+ * No DOM is built: every call yields the next token, validated against
+ * the JSON grammar. Documents may be pretty-printed over many lines, be
+ * larger than the reader's buffer, or follow each other (NDJSON or
+ * concatenated JSON). Since bytes are consumed through the reader, the
+ * reader's position reports where a token or error is.
+ */
+typedef struct
+{
+    stdi_reader_t *reader;                          // The reader to pull bytes from
+    uint8_t containers[STDI_JSON_MAX_DEPTH / 8];    // Bit stack, 1 for objects and 0 for arrays
+    size_t depth;                                   // Number of open containers
+    stdi_json_state_t state;                        // What is expected next
+} stdi_json_t;
+
+/**
+ * @brief Initializes a JSON tokenizer over a reader.
+ *
+ * @param json The tokenizer to initialize.
+ * @param reader The reader to pull bytes from.
+ */
+static inline void stdi_json_init(stdi_json_t *json, stdi_reader_t *reader)
+{
+    json->reader = reader;
+    json->depth = 0;
+    json->state = STDI_JSON_EXPECT_VALUE;
+}
+
+/**
+ * @brief Reads once more into a reader for a token that runs past the buffered bytes.
+ *
+ * Only a single read is made, so a token that is complete on a live stream
+ * never waits for bytes that come after it.
+ *
+ * @param reader The reader to refill.
+ * @param data Receives a pointer to the unconsumed bytes, which may have moved.
+ * @param length Receives the number of unconsumed bytes.
+ * @return The number of bytes added, 0 on end of input, or -1 if an error occurs.
+ */
+static inline ssize_t stdi_json_more(stdi_reader_t *reader, const char **data, size_t *length)
+{
+    const ssize_t bytes_read = reader->error ? -1 : reader->eof ? 0 : stdi_reader_fill(reader);
+    *data = reader->buffer + reader->start;
+    *length = reader->end - reader->start;
+    return bytes_read;
+}
+
+/**
+ * @brief Finds the next byte that ends the fast path of a string scan.
+ *
+ * Stops at a quote, a backslash or a control byte. When SSE2 is available,
+ * 16 bytes are classified at a time.
+ *
+ * @param data The bytes to scan.
+ * @param start The index to start at.
+ * @param length The number of bytes available.
+ * @return The index of the byte found, or `length` if there is none.
+ */
+static inline size_t stdi_json_scan_string(const char *data, size_t start, const size_t length)
+{
+#   if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; start + 16 <= length; start += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i *) (data + start));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(block, control), block)
+        );
+
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return start + __builtin_ctz(mask);
+        }
+    }
+#   endif
+
+    for (; start < length; start++)
+    {
+        const unsigned char c = (unsigned char) data[start];
+        if (c == '"' || c == '\\' || c <= 0x1F)
+        {
+            return start;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief Checks the JSON number grammar.
+ *
+ * @param data The bytes of the number.
+ * @param length The number of bytes.
+ * @return TRUE if the bytes form a valid JSON number.
+ */
+static inline bool stdi_json_valid_number(const char *data, const size_t length)
+{
+    size_t i = 0;
+    i += i < length && data[i] == '-';
+
+    // Integer part, without leading zeros
+    if (i < length && data[i] == '0')
+    {
+        i++;
+    }
+    else
+    {
+        const size_t start = i;
+        while (i < length && (unsigned char) (data[i] - '0') <= 9)
+        {
+            i++;
+        }
+
+        if (i == start)
+        {
+            return FALSE;
+        }
+    }
+
+    // Fraction
+    if (i < length && data[i] == '.')
+    {
+        const size_t start = ++i;
+        while (i < length && (unsigned char) (data[i] - '0') <= 9)
+        {
+            i++;
+        }
+
+        if (i == start)
+        {
+            return FALSE;
+        }
+    }
+
+    // Exponent
+    if (i < length && (data[i] == 'e' || data[i] == 'E'))
+    {
+        i++;
+        i += i < length && (data[i] == '+' || data[i] == '-');
+
+        const size_t start = i;
+        while (i < length && (unsigned char) (data[i] - '0') <= 9)
+        {
+            i++;
+        }
+
+        if (i == start)
+        {
+            return FALSE;
+        }
+    }
+
+    return i == length;
+}
+
+/**
+ * @brief Marks a tokenizer as failed and builds an error token.
+ *
+ * @param json The tokenizer.
+ * @param token Receives the error token.
+ * @return STDI_JSON_ERROR.
+ */
+static inline stdi_json_token_type_t stdi_json_fail(stdi_json_t *json, stdi_json_token_t *token)
+{
+    json->state = STDI_JSON_FAILED;
+    token->type = STDI_JSON_ERROR;
+    token->depth = json->depth;
+    token->value.data = NULL;
+    token->value.length = 0;
+    return STDI_JSON_ERROR;
+}
+
+/**
+ * @brief Reads the next token from a JSON tokenizer.
+ *
+ * @param json The tokenizer to advance.
+ * @param token Receives the token.
+ * @return The type of the token. After STDI_JSON_END or STDI_JSON_ERROR,
+ *         the same type keeps being returned.
+ */
+static inline stdi_json_token_type_t stdi_json_next(stdi_json_t *json, stdi_json_token_t *token)
+{
+    stdi_reader_t *reader = json->reader;
+    token->escaped = FALSE;
+    token->value.data = NULL;
+    token->value.length = 0;
+
+    if (json->state == STDI_JSON_FAILED)
+    {
+        return stdi_json_fail(json, token);
+    }
+
+    while (TRUE)
+    {
+        // Skip whitespace
+        size_t length = reader->end - reader->start;
+        const char *data = reader->buffer + reader->start;
+        if (length == 0 && stdi_json_more(reader, &data, &length) == -1)
+        {
+            return stdi_json_fail(json, token);
+        }
+
+        size_t skipped = 0;
+        while (skipped < length && (data[skipped] == ' ' || data[skipped] == '\n'
+            || data[skipped] == '\r' || data[skipped] == '\t'))
+        {
+            skipped++;
+        }
+
+        stdi_reader_consume(reader, skipped);
+        if (skipped == length)
+        {
+            if (length > 0)
+            {
+                continue;
+            }
+
+            // The input may only end between documents
+            if (json->state == STDI_JSON_EXPECT_VALUE && json->depth == 0)
+            {
+                token->type = STDI_JSON_END;
+                token->depth = 0;
+                return STDI_JSON_END;
+            }
+
+            return stdi_json_fail(json, token);
+        }
+
+        data += skipped;
+        length -= skipped;
+        const char c = data[0];
+        const bool in_object = json->depth > 0
+            && (json->containers[(json->depth - 1) / 8] >> ((json->depth - 1) % 8)) & 1;
+
+        token->depth = json->depth;
+
+        switch (json->state)
+        {
+            case STDI_JSON_EXPECT_COLON:
+            {
+                if (c != ':')
+                {
+                    return stdi_json_fail(json, token);
+                }
+
+                stdi_reader_consume(reader, 1);
+                json->state = STDI_JSON_EXPECT_VALUE;
+                continue;
+            }
+
+            case STDI_JSON_EXPECT_COMMA_OR_END:
+            {
+                if (c == ',')
+                {
+                    stdi_reader_consume(reader, 1);
+                    json->state = in_object ? STDI_JSON_EXPECT_KEY : STDI_JSON_EXPECT_VALUE;
+                    continue;
+                }
+
+                break;
+            }
+
+            case STDI_JSON_EXPECT_KEY:
+            case STDI_JSON_EXPECT_KEY_OR_END:
+            {
+                if (c != '"' && !(c == '}' && json->state == STDI_JSON_EXPECT_KEY_OR_END))
+                {
+                    return stdi_json_fail(json, token);
+                }
+
+                break;
+            }
+
+            case STDI_JSON_EXPECT_VALUE:
+            {
+                if (c == ']' || c == '}')
+                {
+                    return stdi_json_fail(json, token);
+                }
+
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+
+        // Handle the end of containers
+        if (c == '}' || c == ']')
+        {
+            if (json->state == STDI_JSON_EXPECT_VALUE || json->state == STDI_JSON_EXPECT_KEY
+                || json->depth == 0 || in_object != (c == '}')
+                || (json->state == STDI_JSON_EXPECT_VALUE_OR_END && c != ']'))
+            {
+                return stdi_json_fail(json, token);
+            }
+
+            stdi_reader_consume(reader, 1);
+            json->depth--;
+            json->state = json->depth == 0 ? STDI_JSON_EXPECT_VALUE : STDI_JSON_EXPECT_COMMA_OR_END;
+            token->type = c == '}' ? STDI_JSON_END_OBJECT : STDI_JSON_END_ARRAY;
+            token->depth = json->depth;
+            return token->type;
+        }
+
+        // Everything else is a value (or a key)
+        if (json->state == STDI_JSON_EXPECT_COMMA_OR_END)
+        {
+            return stdi_json_fail(json, token);
+        }
+
+        const bool key = json->state == STDI_JSON_EXPECT_KEY || json->state == STDI_JSON_EXPECT_KEY_OR_END;
+        json->state = json->depth == 0 ? STDI_JSON_EXPECT_VALUE : STDI_JSON_EXPECT_COMMA_OR_END;
+
+        if (c == '{' || c == '[')
+        {
+            if (json->depth == STDI_JSON_MAX_DEPTH)
+            {
+                return stdi_json_fail(json, token);
+            }
+
+            // Push the container
+            const size_t byte = json->depth / 8;
+            const uint8_t bit = (uint8_t) (1 << (json->depth % 8));
+            json->containers[byte] = c == '{' ? json->containers[byte] | bit : json->containers[byte] & ~bit;
+            json->depth++;
+
+            stdi_reader_consume(reader, 1);
+            json->state = c == '{' ? STDI_JSON_EXPECT_KEY_OR_END : STDI_JSON_EXPECT_VALUE_OR_END;
+            token->type = c == '{' ? STDI_JSON_BEGIN_OBJECT : STDI_JSON_BEGIN_ARRAY;
+            return token->type;
+        }
+
+        if (c == '"')
+        {
+            // Find the closing quote, refilling as needed
+            size_t end = 1;
+            while (TRUE)
+            {
+                if (end < length)
+                {
+                    end = stdi_json_scan_string(data, end, length);
+
+                    if (end < length && data[end] == '"')
+                    {
+                        break;
+                    }
+
+                    if (end < length && data[end] == '\\')
+                    {
+                        token->escaped = TRUE;
+                        end += 2;
+                        continue;
+                    }
+
+                    // Control bytes must be escaped
+                    if (end < length)
+                    {
+                        return stdi_json_fail(json, token);
+                    }
+                }
+
+                // Read further and rescan from `end`, the input may not end inside a string
+                if (stdi_json_more(reader, &data, &length) <= 0)
+                {
+                    return stdi_json_fail(json, token);
+                }
+            }
+
+            token->type = key ? STDI_JSON_KEY : STDI_JSON_STRING;
+            token->value.data = data + 1;
+            token->value.length = end - 1;
+            stdi_reader_consume(reader, end + 1);
+
+            if (key)
+            {
+                json->state = STDI_JSON_EXPECT_COLON;
+            }
+
+            return token->type;
+        }
+
+        if (key)
+        {
+            return stdi_json_fail(json, token);
+        }
+
+        // Find the end of a number or literal, refilling as needed
+        size_t end = 0;
+        while (TRUE)
+        {
+            while (end < length && (data[end] == '-' || data[end] == '+' || data[end] == '.'
+                || (data[end] >= '0' && data[end] <= '9') || (data[end] >= 'a' && data[end] <= 'z')
+                || (data[end] >= 'A' && data[end] <= 'Z')))
+            {
+                end++;
+            }
+
+            if (end < length)
+            {
+                break;
+            }
+
+            // Read further and continue from `end`, the input may end right after the token
+            const ssize_t bytes_read = stdi_json_more(reader, &data, &length);
+            if (bytes_read == -1)
+            {
+                return stdi_json_fail(json, token);
+            }
+
+            if (bytes_read == 0)
+            {
+                break;
+            }
+        }
+
+        if (end == 4 && memcmp(data, "true", 4) == 0)
+        {
+            token->type = STDI_JSON_TRUE;
+        }
+        else if (end == 5 && memcmp(data, "false", 5) == 0)
+        {
+            token->type = STDI_JSON_FALSE;
+        }
+        else if (end == 4 && memcmp(data, "null", 4) == 0)
+        {
+            token->type = STDI_JSON_NULL;
+        }
+        else if (stdi_json_valid_number(data, end))
+        {
+            token->type = STDI_JSON_NUMBER;
+            token->value.data = data;
+            token->value.length = end;
+        }
+        else
+        {
+            return stdi_json_fail(json, token);
+        }
+
+        stdi_reader_consume(reader, end);
+        return token->type;
+    }
+}
+
+/**
+ * @brief Decodes the escape sequences of a raw JSON string.
+ *
+ * The output is never longer than the input, so `output` needs at most
+ * `raw->length` bytes. Unpaired surrogates are replaced with U+FFFD.
+ *
+ * @param raw The raw string, as found in a token's value.
+ * @param output Receives the decoded UTF-8 bytes.
+ * @return The number of bytes written, or -1 if an escape sequence is invalid.
+ */
+static inline ssize_t stdi_json_unescape(const stdi_view_t *raw, char *output)
+{
+    const char *cursor = raw->data;
+    const char *end = raw->data + raw->length;
+    size_t written = 0;
+
+    while (cursor < end)
+    {
+        // Copy everything up to the next escape sequence
+        const char *backslash = memchr(cursor, '\\', end - cursor);
+        const size_t plain = (backslash == NULL ? end : backslash) - cursor;
+        memmove(output + written, cursor, plain);
+        written += plain;
+        cursor += plain;
+
+        if (cursor == end)
+        {
+            break;
+        }
+
+        if (cursor + 1 == end)
+        {
+            return -1;
+        }
+
+        const char escape = cursor[1];
+        cursor += 2;
+
+        switch (escape)
+        {
+            case '"': output[written++] = '"'; break;
+            case '\\': output[written++] = '\\'; break;
+            case '/': output[written++] = '/'; break;
+            case 'b': output[written++] = '\b'; break;
+            case 'f': output[written++] = '\f'; break;
+            case 'n': output[written++] = '\n'; break;
+            case 'r': output[written++] = '\r'; break;
+            case 't': output[written++] = '\t'; break;
+            case 'u':
+            {
+                uint32_t units[2] = { 0, 0 };
+                size_t count = 0;
+
+                // Read one code unit, and a second one for surrogate pairs
+                while (count < 2)
+                {
+                    if (end - cursor < 4)
+                    {
+                        return -1;
+                    }
+
+                    for (size_t i = 0; i < 4; i++)
+                    {
+                        const char h = cursor[i];
+                        const int value = h >= '0' && h <= '9' ? h - '0'
+                            : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                            : h >= 'A' && h <= 'F' ? h - 'A' + 10
+                            : -1;
+
+                        if (value < 0)
+                        {
+                            return -1;
+                        }
+
+                        units[count] = units[count] << 4 | (uint32_t) value;
+                    }
+
+                    cursor += 4;
+                    count++;
+
+                    // Only a high surrogate may be followed by a second unit
+                    if (count == 2 || units[0] < 0xD800 || units[0] > 0xDBFF || end - cursor < 6
+                        || cursor[0] != '\\' || cursor[1] != 'u')
+                    {
+                        break;
+                    }
+
+                    cursor += 2;
+                }
+
+                uint32_t code_point = units[0];
+                if (count == 2 && units[1] >= 0xDC00 && units[1] <= 0xDFFF)
+                {
+                    code_point = 0x10000 + ((units[0] - 0xD800) << 10) + (units[1] - 0xDC00);
+                    count = 1;
+                }
+                else if (units[0] >= 0xD800 && units[0] <= 0xDFFF)
+                {
+                    code_point = 0xFFFD;
+                }
+
+                written += stdi_utf8_encode(code_point, output + written);
+
+                // Decode a second unit that did not complete a pair on its own
+                if (count == 2)
+                {
+                    const uint32_t second = units[1] >= 0xD800 && units[1] <= 0xDFFF ? 0xFFFD : units[1];
+                    written += stdi_utf8_encode(second, output + written);
+                }
+
+                break;
+            }
+            default:
+            {
+                return -1;
+            }
+        }
+    }
+
+    return (ssize_t) written;
+}
+
+/**
+ * @brief Spawns a child process and connects its standard output to a reader.
+ *
+ * The child is started with posix_spawnp, so `argv[0]` is looked up in
+ * PATH, and inherits the environment and every other descriptor. The pipe
+ * is created close-on-exec, so other children do not keep it open, and
+ * enlarged to STDI_SPAWN_PIPE_SIZE where supported to cut the number of
+ * context switches. The reader can then be used like one over stdin.
+ *
+ * @param reader Receives a reader over the child's standard output.
+ * @param argv The NULL-terminated argument vector of the child.
+ * @param pid Receives the process ID of the child.
+ * @return TRUE on success, FALSE if the pipe, the reader or the child could not be created.
+ *
+ * @note Call stdi_spawn_wait once done reading to release the reader and reap the child.
+ */
+static inline bool stdi_spawn_read(stdi_reader_t *reader, char *const argv[], pid_t *pid)
+{
+    extern char **environ;
+
+    // Create the pipe without leaking it into other children
+    int fds[2];
+#   if defined(__linux__)
+    if (pipe2(fds, O_CLOEXEC) == -1)
+    {
+        return FALSE;
+    }
+#   else
+    if (pipe(fds) == -1)
+    {
+        return FALSE;
+    }
+
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#   endif
+
+#   if defined(__linux__)
+    // Enlarge the pipe, this is only a hint
+    fcntl(fds[0], 1031 /* F_SETPIPE_SZ */, STDI_SPAWN_PIPE_SIZE);
+#   endif
+
+    // Connect the write end to the child's stdout, dup2 clears close-on-exec
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) != 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return FALSE;
+    }
+
+    int result = posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    if (result == 0)
+    {
+        result = posix_spawnp(pid, argv[0], &actions, NULL, argv, environ);
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (result != 0)
+    {
+        close(fds[0]);
+        errno = result;
+        return FALSE;
+    }
+
+    // Read the other end
+    if (!stdi_reader_init(reader, fds[0], 0))
+    {
+        close(fds[0]);
+        waitpid(*pid, NULL, 0);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Releases a reader created by stdi_spawn_read and waits for its child.
+ *
+ * The read end of the pipe is closed first, so a child still writing gets
+ * SIGPIPE instead of blocking forever.
+ *
+ * @param reader The reader to release.
+ * @param pid The process ID of the child.
+ * @return The wait status of the child (see WIFEXITED), or -1 if waiting fails.
+ */
+static inline int stdi_spawn_wait(stdi_reader_t *reader, const pid_t pid)
+{
+    close(reader->fd);
+    stdi_reader_destroy(reader);
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        // Retry if we got interrupted by a signal
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+
+    return status;
+}
+
+#if STDI_ENABLE_HISTOGRAMS
+/**
+ * @brief Merges the histograms of every thread that recorded samples.
+ *
+ * Threads may keep recording while this runs, the snapshot then includes
+ * some of their latest samples.
+ *
+ * @param kind The histogram to merge.
+ * @param histogram Receives the merged histogram.
+ */
+static inline void stdi_histogram_snapshot(const stdi_histogram_kind_t kind, stdi_histogram_t *histogram)
+{
+    memset(histogram, 0, sizeof(stdi_histogram_t));
+
+    stdi_histogram_thread_t *block = __atomic_load_n(&stdi_histogram_threads, __ATOMIC_ACQUIRE);
+    for (; block != NULL; block = block->next)
+    {
+        for (size_t i = 0; i < STDI_HISTOGRAM_BUCKETS; i++)
+        {
+            histogram->counts[i] += __atomic_load_n(&block->histograms[kind].counts[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Returns the duration below which a fraction of the samples fall.
+ *
+ * @param histogram The histogram to query.
+ * @param fraction The fraction of samples, e.g. 0.99 for the 99th percentile.
+ * @return The lower bound of the bucket holding the percentile in nanoseconds,
+ *         or 0 if the histogram is empty.
+ */
+static inline uint64_t stdi_histogram_percentile(const stdi_histogram_t *histogram, const double fraction)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < STDI_HISTOGRAM_BUCKETS; i++)
+    {
+        total += histogram->counts[i];
+    }
+
+    // Walk the buckets until the rank is reached
+    const uint64_t rank = (uint64_t) (fraction * (double) total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < STDI_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->counts[i];
+        if (seen > rank || (seen == total && seen > 0))
+        {
+            return stdi_histogram_value(i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Formats an unsigned integer in decimal.
+ *
+ * @param value The value to format.
+ * @param output A pointer to at least 20 writable bytes.
+ * @return The number of bytes written.
+ */
+static inline size_t stdi_format_u64(uint64_t value, char *output)
+{
+    char digits[20];
+    size_t count = 0;
+
+    do
+    {
+        digits[count++] = (char) ('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        output[i] = digits[count - 1 - i];
+    }
+
+    return count;
+}
+
+/**
+ * @brief Writes a report of the latency histograms to a file descriptor.
+ *
+ * For each histogram a summary line is written, followed by one line per
+ * non-empty bucket so the distribution can be plotted:
+ *
+ *     read count=1200 p50=1984 p90=30720 p99=491520 p999=983040 max=1048576
+ *     read 1984 640
+ *     ...
+ *
+ * All durations are in nanoseconds. A large `read` tail next to a small
+ * `line` distribution means the process is starved by its producer, the
+ * opposite means it is bound by its own per-line work.
+ *
+ * @param fd The file descriptor to write to (e.g. STDERR_FILENO).
+ * @return TRUE on success, FALSE if an error occurs.
+ */
+static inline bool stdi_histogram_dump(const int fd)
+{
+    static const char *names[STDI_HISTOGRAM_KINDS] = { "read", "line" };
+    static const char *labels[] = { " p50=", " p90=", " p99=", " p999=", " max=" };
+    static const double fractions[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+    stdi_writer_t writer;
+    if (!stdi_writer_init(&writer, fd, 0, STDI_FLUSH_EXPLICIT))
+    {
+        return FALSE;
+    }
+
+    stdi_histogram_t *histogram = malloc(sizeof(stdi_histogram_t));
+    if (histogram == NULL)
+    {
+        stdi_writer_destroy(&writer);
+        return FALSE;
+    }
+
+    char number[20];
+    for (size_t kind = 0; kind < STDI_HISTOGRAM_KINDS; kind++)
+    {
+        stdi_histogram_snapshot((stdi_histogram_kind_t) kind, histogram);
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < STDI_HISTOGRAM_BUCKETS; i++)
+        {
+            total += histogram->counts[i];
+        }
+
+        // Write the summary
+        stdi_writer_write(&writer, names[kind], strlen(names[kind]));
+        stdi_writer_write(&writer, " count=", 7);
+        stdi_writer_write(&writer, number, stdi_format_u64(total, number));
+
+        for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++)
+        {
+            stdi_writer_write(&writer, labels[i], strlen(labels[i]));
+            stdi_writer_write(&writer, number, stdi_format_u64(stdi_histogram_percentile(histogram, fractions[i]), number));
+        }
+
+        stdi_writer_write(&writer, "\n", 1);
+
+        // Write the buckets
+        for (size_t i = 0; i < STDI_HISTOGRAM_BUCKETS; i++)
+        {
+            if (histogram->counts[i] == 0)
+            {
+                continue;
+            }
+
+            stdi_writer_write(&writer, names[kind], strlen(names[kind]));
+            stdi_writer_write(&writer, " ", 1);
+            stdi_writer_write(&writer, number, stdi_format_u64(stdi_histogram_value(i), number));
+            stdi_writer_write(&writer, " ", 1);
+            stdi_writer_write_line(&writer, number, stdi_format_u64(histogram->counts[i], number));
+        }
+    }
+
+    free(histogram);
+    const bool success = stdi_writer_flush(&writer) && !writer.error;
+    stdi_writer_destroy(&writer);
+    return success;
+}
+#endif
+
+/**
+ * @brief A minimal reader that is safe to use from signal handlers.
+ *
+ * Unlike stdi_reader_t, it never allocates, locks or polls: its buffer is
+ * inline and it only calls read(2), memchr and memmove, which POSIX lists
+ * as async-signal-safe (unlike syscall(2)). It holds no global state, so it
+ * is also unaffected by fork(). It must own its descriptor, sharing one with
+ * a buffered reader would split the input between them.
+ */
+typedef struct
+{
+    int fd;                                         // Source file descriptor
+    size_t start;                                   // Index of the first unconsumed byte
+    size_t end;                                     // Index one past the last buffered byte
+    bool eof;                                       // Whether the source reported end of input or an error
+    char buffer[STDI_SIGNAL_READER_BUFFER_SIZE];    // Inline read buffer
+} stdi_signal_reader_t;
+
+/**
+ * @brief Initializes a signal-safe reader.
+ *
+ * @param reader The reader to initialize.
+ * @param fd The file descriptor to read from.
+ */
+static inline void stdi_signal_reader_init(stdi_signal_reader_t *reader, const int fd)
+{
+    reader->fd = fd;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = FALSE;
+}
+
+/**
+ * @brief Reads the next line from a signal-safe reader.
+ *
+ * This function is async-signal-safe and preserves errno. Lines longer
+ * than STDI_SIGNAL_READER_BUFFER_SIZE are returned in pieces, with
+ * `complete` set to FALSE for every piece but the last.
+ *
+ * @param reader The reader to read from.
+ * @param length Receives the length of the line (or piece) in bytes.
+ * @param complete Receives whether the line ended within this piece.
+ * @return A pointer into the reader's buffer, valid until the next call,
+ *         or NULL on end of input or error.
+ */
+static inline const char* stdi_signal_read_line(stdi_signal_reader_t *reader, size_t *length, bool *complete)
+{
+    const int saved_errno = errno;
+    const char *line = NULL;
+
+    while (TRUE)
+    {
+        // Look for a newline in the buffered bytes
+        const size_t available = reader->end - reader->start;
+        const char *newline = memchr(reader->buffer + reader->start, '\n', available);
+        if (newline != NULL)
+        {
+            line = reader->buffer + reader->start;
+            *length = newline - line;
+            *complete = TRUE;
+            reader->start += *length + 1;
+            break;
+        }
+
+        // Hand out what we have if the buffer is full or the input ended
+        if (available == sizeof(reader->buffer) || (reader->eof && available > 0))
+        {
+            line = reader->buffer + reader->start;
+            *length = available;
+            *complete = reader->eof;
+            reader->start = reader->end;
+            break;
+        }
+
+        if (reader->eof)
+        {
+            break;
+        }
+
+        // Move the partial line to the front and read more
+        memmove(reader->buffer, reader->buffer + reader->start, available);
+        reader->start = 0;
+        reader->end = available;
+
+        const ssize_t bytes_read = read(reader->fd, reader->buffer + available, sizeof(reader->buffer) - available);
+        if (bytes_read == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes_read <= 0)
+        {
+            reader->eof = TRUE;
+            continue;
+        }
+
+        reader->end += bytes_read;
+    }
+
+    errno = saved_errno;
+    return line;
+}
+
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
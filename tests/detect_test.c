@@ -0,0 +1,189 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Writes bytes to a file descriptor, failing the test on short writes.
+ */
+static void write_bytes(const int fd, const char *data, const size_t length)
+{
+    CHECK(write(fd, data, length) == (ssize_t) length);
+}
+
+/**
+ * @brief Peeking returns what a single read delivers instead of waiting for more.
+ */
+static void test_peek_live_stream()
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fds[0], 8));
+
+    // The pipe stays open, a peek waiting for 100 bytes would hang
+    size_t length;
+    write_bytes(fds[1], "ab", 2);
+    const char *view = stdi_peek(&reader, 100, &length);
+    CHECK(view != NULL && length == 2 && memcmp(view, "ab", 2) == 0);
+    CHECK(!reader.eof);
+
+    // Peeking again reads once more and keeps the earlier bytes
+    write_bytes(fds[1], "cdef", 4);
+    view = stdi_peek(&reader, 100, &length);
+    CHECK(view != NULL && length == 6 && memcmp(view, "abcdef", 6) == 0);
+
+    // Enough bytes are buffered, so nothing is read
+    view = stdi_peek(&reader, 3, &length);
+    CHECK(view != NULL && length == 3 && memcmp(view, "abc", 3) == 0);
+
+    // Consumed bytes make room for the next peek in the same buffer
+    CHECK(stdi_reader_consume(&reader, 5) == 5);
+    write_bytes(fds[1], "ghijklm", 7);
+    view = stdi_peek(&reader, 8, &length);
+    CHECK(view != NULL && length == 8 && memcmp(view, "fghijklm", 8) == 0);
+
+    // Nothing was consumed by peeking
+    size_t line_length;
+    write_bytes(fds[1], "\n", 1);
+    close(fds[1]);
+    const char *line = stdi_reader_next_line(&reader, &line_length);
+    CHECK(line != NULL && line_length == 8 && memcmp(line, "fghijklm", 8) == 0);
+
+    // The end of input is reported as an empty view
+    view = stdi_peek(&reader, 4, &length);
+    CHECK(view != NULL && length == 0 && reader.eof);
+
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Detects the format of the given bytes, fed through a closed pipe.
+ */
+static stdi_format_t detect(const char *data, const size_t length)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    write_bytes(fds[1], data, length);
+    close(fds[1]);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fds[0], 0));
+    const stdi_format_t format = stdi_detect_format(&reader);
+
+    // Detection consumes nothing
+    CHECK(reader.start == 0 && reader.end == length);
+
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+    return format;
+}
+
+#define DETECT(literal) detect(literal, sizeof(literal) - 1)
+
+/**
+ * @brief Every format is recognized from its first block.
+ */
+static void test_formats()
+{
+    CHECK(DETECT("") == STDI_FORMAT_EMPTY);
+    CHECK(DETECT("hello world\nsecond line\n") == STDI_FORMAT_TEXT);
+    CHECK(DETECT("\x1F\x8B\x08\x00") == STDI_FORMAT_GZIP);
+    CHECK(DETECT("\x28\xB5\x2F\xFD\x00") == STDI_FORMAT_ZSTD);
+    CHECK(DETECT("\xEF\xBB\xBFtext\n") == STDI_FORMAT_UTF8_BOM);
+    CHECK(DETECT("\xFF\xFEh\0i\0") == STDI_FORMAT_UTF16LE);
+    CHECK(DETECT("\xFE\xFF\0h\0i") == STDI_FORMAT_UTF16BE);
+    CHECK(DETECT("h\0e\0l\0l\0o\0\n\0") == STDI_FORMAT_UTF16LE);
+    CHECK(DETECT("\0h\0e\0l\0l\0o\0\n") == STDI_FORMAT_UTF16BE);
+    CHECK(DETECT("{\"a\":1}\n{\"a\":2}\n") == STDI_FORMAT_NDJSON);
+    CHECK(DETECT("  [1, 2]  \r\n") == STDI_FORMAT_NDJSON);
+    CHECK(DETECT("a,b,c\n1,2,3\n4,5,6\n") == STDI_FORMAT_CSV);
+    CHECK(DETECT("a\tb\n1\t2\n") == STDI_FORMAT_TSV);
+    CHECK(DETECT("a,b\n1,2,3\n") == STDI_FORMAT_TEXT);
+    CHECK(DETECT("\x01\x02\x03\x04\x05\x06" "abc") == STDI_FORMAT_BINARY);
+    CHECK(DETECT("ab\0cd\0\0ef") == STDI_FORMAT_BINARY);
+}
+
+/**
+ * @brief Detection classifies what the peer has sent so far instead of
+ *        waiting for a full block.
+ */
+static void test_detect_live_stream()
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fds[0], 0));
+
+    // The pipe stays open, waiting for STDI_DETECT_BLOCK_SIZE bytes would hang
+    write_bytes(fds[1], "HELLO v1\n", 9);
+    CHECK(stdi_detect_format(&reader) == STDI_FORMAT_TEXT);
+
+    size_t length;
+    const char *line = stdi_reader_next_line(&reader, &length);
+    CHECK(line != NULL && length == 8 && memcmp(line, "HELLO v1", 8) == 0);
+
+    close(fds[1]);
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Read errors are reported instead of a format.
+ */
+static void test_detect_error()
+{
+    const int fd = open("/", O_RDONLY);
+    CHECK(fd != -1);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fd, 0));
+    CHECK(stdi_detect_format(&reader) == STDI_FORMAT_ERROR);
+    CHECK(reader.error);
+
+    close(fd);
+    stdi_reader_destroy(&reader);
+}
+
+int main()
+{
+    // Fail instead of hanging if peeking blocks on a live stream
+    alarm(10);
+
+    test_peek_live_stream();
+    test_formats();
+    test_detect_live_stream();
+    test_detect_error();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
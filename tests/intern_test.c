@@ -0,0 +1,157 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+// stdi.h defines this itself, but stdlib.h has to come first here
+#define _GNU_SOURCE
+#include <stdlib.h>
+
+// Route the library's allocations through failure-injecting wrappers
+static int failing_allocations = 0;
+
+static void* test_malloc(const size_t size)
+{
+    return failing_allocations-- > 0 ? NULL : malloc(size);
+}
+
+static void* test_calloc(const size_t count, const size_t size)
+{
+    return failing_allocations-- > 0 ? NULL : calloc(count, size);
+}
+
+#define malloc test_malloc
+#define calloc test_calloc
+#include "../stdi.h"
+#undef malloc
+#undef calloc
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Checks that every string "key <i>" below `count` has the ID i.
+ */
+static void expect_keys(stdi_intern_t *intern, const int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        char key[32];
+        const int length = snprintf(key, sizeof(key), "key %d", i);
+        uint32_t id = UINT32_MAX;
+        const char *copy = stdi_intern(intern, key, (size_t) length, &id);
+        CHECK(copy != NULL && id == (uint32_t) i);
+        CHECK(copy != NULL && strcmp(copy, key) == 0);
+    }
+}
+
+/**
+ * @brief Equal strings share an ID and a copy, IDs are dense.
+ */
+static void test_ids(void)
+{
+    stdi_intern_t intern;
+    CHECK(stdi_intern_init(&intern));
+
+    uint32_t first;
+    uint32_t second;
+    uint32_t again;
+    const char *a = stdi_intern(&intern, "alpha", 5, &first);
+    const char *b = stdi_intern(&intern, "alp", 3, &second);
+    const char *c = stdi_intern(&intern, "alpha", 5, &again);
+    CHECK(a != NULL && a == c && a != b);
+    CHECK(first == 0 && second == 1 && again == 0);
+    CHECK(intern.count == 2);
+
+    // Embedded NUL bytes are part of the string
+    CHECK(stdi_intern(&intern, "a\0b", 3, NULL) != stdi_intern(&intern, "a\0c", 3, NULL));
+
+    size_t length;
+    CHECK(stdi_intern_lookup(&intern, 1, &length) == b && length == 3);
+    CHECK(stdi_intern_lookup(&intern, 4, NULL) == NULL);
+    stdi_intern_destroy(&intern);
+}
+
+/**
+ * @brief IDs stay stable while the tables grow.
+ */
+static void test_growth(void)
+{
+    stdi_intern_t intern;
+    CHECK(stdi_intern_init(&intern));
+    expect_keys(&intern, 5000);
+    expect_keys(&intern, 5000);
+    CHECK(intern.count == 5000);
+    CHECK(intern.count * 2 <= intern.slot_count);
+    stdi_intern_destroy(&intern);
+}
+
+/**
+ * @brief A failed allocation leaves the table unchanged and usable.
+ */
+static void test_allocation_failure(void)
+{
+    stdi_intern_t intern;
+    CHECK(stdi_intern_init(&intern));
+
+    // Fill the slot table up to its load factor
+    const int count = (int) intern.slot_count / 2;
+    expect_keys(&intern, count);
+    const size_t bytes = intern.pool.bytes;
+
+    // The slot table cannot grow
+    failing_allocations = 1;
+    CHECK(stdi_intern(&intern, "new", 3, NULL) == NULL);
+    CHECK(intern.count == (size_t) count);
+    CHECK(intern.pool.bytes == bytes);
+
+    failing_allocations = 0;
+    CHECK(stdi_intern(&intern, "new", 3, NULL) != NULL);
+
+    // The copy cannot be stored, large strings get a block of their own
+    char large[STDI_STRING_POOL_BLOCK_SIZE];
+    memset(large, 'x', sizeof(large));
+    failing_allocations = 1;
+    CHECK(stdi_intern(&intern, large, sizeof(large), NULL) == NULL);
+    CHECK(intern.count == (size_t) count + 1);
+
+    // Everything still works afterwards
+    failing_allocations = 0;
+    uint32_t id;
+    CHECK(stdi_intern(&intern, large, sizeof(large), &id) != NULL && id == (uint32_t) count + 1);
+    CHECK(stdi_intern(&intern, "new", 3, &id) != NULL && id == (uint32_t) count);
+    expect_keys(&intern, count);
+    stdi_intern_destroy(&intern);
+}
+
+int main(void)
+{
+    test_ids();
+    test_growth();
+    test_allocation_failure();
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
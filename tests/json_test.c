@@ -0,0 +1,289 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Writes a string to a file descriptor, failing the test on short writes.
+ */
+static void write_all(const int fd, const char *data)
+{
+    CHECK(write(fd, data, strlen(data)) == (ssize_t) strlen(data));
+}
+
+/**
+ * @brief Checks the next token's type and, when given, its value.
+ */
+static void expect(stdi_json_t *json, const stdi_json_token_type_t type, const char *value)
+{
+    stdi_json_token_t token;
+    const stdi_json_token_type_t actual = stdi_json_next(json, &token);
+    CHECK(actual == type);
+
+    if (actual == type && value != NULL)
+    {
+        CHECK(token.value.length == strlen(value));
+        CHECK(memcmp(token.value.data, value, strlen(value)) == 0);
+    }
+}
+
+/**
+ * @brief Opens a reader over the given input, fed through a pipe.
+ */
+static void open_input(stdi_reader_t *reader, const char *input, const size_t capacity)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    write_all(fds[1], input);
+    close(fds[1]);
+    CHECK(stdi_reader_init(reader, fds[0], capacity));
+}
+
+/**
+ * @brief Closes a reader opened by open_input.
+ */
+static void close_input(stdi_reader_t *reader)
+{
+    close(reader->fd);
+    stdi_reader_destroy(reader);
+}
+
+/**
+ * @brief Tokens that straddle a read boundary of a live stream are returned
+ *        as soon as they are complete.
+ */
+static void test_split_tokens()
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    stdi_reader_t reader;
+    stdi_json_t json;
+    CHECK(stdi_reader_init(&reader, fds[0], 0));
+    stdi_json_init(&json, &reader);
+
+    // The pipe stays open, a tokenizer waiting for more bytes would hang
+    write_all(fds[1], "{\"a\":\"xyzw");
+    expect(&json, STDI_JSON_BEGIN_OBJECT, NULL);
+    expect(&json, STDI_JSON_KEY, "a");
+    write_all(fds[1], "\"}");
+    expect(&json, STDI_JSON_STRING, "xyzw");
+    expect(&json, STDI_JSON_END_OBJECT, NULL);
+    write_all(fds[1], "\n{\"b\":tr");
+    expect(&json, STDI_JSON_BEGIN_OBJECT, NULL);
+    expect(&json, STDI_JSON_KEY, "b");
+    write_all(fds[1], "ue,\"c\":-1");
+    expect(&json, STDI_JSON_TRUE, NULL);
+    expect(&json, STDI_JSON_KEY, "c");
+    write_all(fds[1], "2.5e3]");
+    expect(&json, STDI_JSON_NUMBER, "-12.5e3");
+    expect(&json, STDI_JSON_ERROR, NULL);
+
+    close(fds[1]);
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Strings and numbers larger than the buffer are returned whole.
+ */
+static void test_large_tokens()
+{
+    char input[4096];
+    memset(input, 0, sizeof(input));
+    input[0] = '[';
+    input[1] = '"';
+    memset(input + 2, 'x', 2000);
+    strcat(input, "\",123456789012345678901234567890]");
+
+    stdi_reader_t reader;
+    stdi_json_t json;
+    open_input(&reader, input, 4);
+    stdi_json_init(&json, &reader);
+
+    stdi_json_token_t token;
+    expect(&json, STDI_JSON_BEGIN_ARRAY, NULL);
+    CHECK(stdi_json_next(&json, &token) == STDI_JSON_STRING && token.value.length == 2000);
+    expect(&json, STDI_JSON_NUMBER, "123456789012345678901234567890");
+    expect(&json, STDI_JSON_END_ARRAY, NULL);
+    expect(&json, STDI_JSON_END, NULL);
+    close_input(&reader);
+}
+
+/**
+ * @brief Escapes are kept raw in tokens and decoded by stdi_json_unescape.
+ */
+static void test_escapes()
+{
+    stdi_reader_t reader;
+    stdi_json_t json;
+    open_input(&reader, "[\"q\\\"b\\\\s\\/n\\n\\u00e9\\ud83d\\ude00\\ud800x\", \"bad\\q\"]", 8);
+    stdi_json_init(&json, &reader);
+
+    stdi_json_token_t token;
+    expect(&json, STDI_JSON_BEGIN_ARRAY, NULL);
+    CHECK(stdi_json_next(&json, &token) == STDI_JSON_STRING && token.escaped);
+
+    char output[64];
+    const ssize_t length = stdi_json_unescape(&token.value, output);
+    const char *expected = "q\"b\\s/n\n\xC3\xA9\xF0\x9F\x98\x80\xEF\xBF\xBDx";
+    CHECK(length == (ssize_t) strlen(expected));
+    CHECK(length > 0 && memcmp(output, expected, length) == 0);
+
+    CHECK(stdi_json_next(&json, &token) == STDI_JSON_STRING);
+    CHECK(stdi_json_unescape(&token.value, output) == -1);
+    close_input(&reader);
+
+    // Control bytes must be escaped
+    open_input(&reader, "\"a\tb\"", 0);
+    stdi_json_init(&json, &reader);
+    expect(&json, STDI_JSON_ERROR, NULL);
+    close_input(&reader);
+}
+
+/**
+ * @brief Nesting deeper than STDI_JSON_MAX_DEPTH is rejected.
+ */
+static void test_depth_limit()
+{
+    static char input[STDI_JSON_MAX_DEPTH * 2 + 4];
+
+    // Exactly the maximum depth is accepted
+    memset(input, '[', STDI_JSON_MAX_DEPTH);
+    memset(input + STDI_JSON_MAX_DEPTH, ']', STDI_JSON_MAX_DEPTH);
+    input[STDI_JSON_MAX_DEPTH * 2] = '\0';
+
+    stdi_reader_t reader;
+    stdi_json_t json;
+    stdi_json_token_t token;
+    open_input(&reader, input, 0);
+    stdi_json_init(&json, &reader);
+
+    size_t tokens = 0;
+    while (stdi_json_next(&json, &token) != STDI_JSON_END && token.type != STDI_JSON_ERROR)
+    {
+        tokens++;
+    }
+
+    CHECK(token.type == STDI_JSON_END);
+    CHECK(tokens == STDI_JSON_MAX_DEPTH * 2);
+    close_input(&reader);
+
+    // One more level fails
+    memset(input, '[', STDI_JSON_MAX_DEPTH + 1);
+    input[STDI_JSON_MAX_DEPTH + 1] = '\0';
+    open_input(&reader, input, 0);
+    stdi_json_init(&json, &reader);
+
+    while (stdi_json_next(&json, &token) == STDI_JSON_BEGIN_ARRAY)
+    {
+    }
+
+    CHECK(token.type == STDI_JSON_ERROR);
+    CHECK(json.depth == STDI_JSON_MAX_DEPTH);
+    close_input(&reader);
+}
+
+/**
+ * @brief Concatenated and newline-delimited documents are read one after another.
+ */
+static void test_concatenated_documents()
+{
+    stdi_reader_t reader;
+    stdi_json_t json;
+    open_input(&reader, "{\"a\":[1,null]}\n{}[]\"s\" 42 false\n", 5);
+    stdi_json_init(&json, &reader);
+
+    expect(&json, STDI_JSON_BEGIN_OBJECT, NULL);
+    expect(&json, STDI_JSON_KEY, "a");
+    expect(&json, STDI_JSON_BEGIN_ARRAY, NULL);
+    expect(&json, STDI_JSON_NUMBER, "1");
+    expect(&json, STDI_JSON_NULL, NULL);
+    expect(&json, STDI_JSON_END_ARRAY, NULL);
+    expect(&json, STDI_JSON_END_OBJECT, NULL);
+    expect(&json, STDI_JSON_BEGIN_OBJECT, NULL);
+    expect(&json, STDI_JSON_END_OBJECT, NULL);
+    expect(&json, STDI_JSON_BEGIN_ARRAY, NULL);
+    expect(&json, STDI_JSON_END_ARRAY, NULL);
+    expect(&json, STDI_JSON_STRING, "s");
+    expect(&json, STDI_JSON_NUMBER, "42");
+    expect(&json, STDI_JSON_FALSE, NULL);
+    expect(&json, STDI_JSON_END, NULL);
+    expect(&json, STDI_JSON_END, NULL);
+    close_input(&reader);
+}
+
+/**
+ * @brief Grammar violations and truncated input are reported as errors.
+ */
+static void test_errors()
+{
+    static const char *inputs[] = {
+        "{\"a\":1,}", "[1 2]", "{\"a\" 1}", "[01]", "[\"abc", "{]", "[1.]", "tru", "{1:2}", "[", "]", "[-]"
+    };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    {
+        stdi_reader_t reader;
+        stdi_json_t json;
+        stdi_json_token_t token;
+        open_input(&reader, inputs[i], 0);
+        stdi_json_init(&json, &reader);
+
+        while (stdi_json_next(&json, &token) != STDI_JSON_ERROR && token.type != STDI_JSON_END)
+        {
+        }
+
+        if (token.type != STDI_JSON_ERROR)
+        {
+            fprintf(stderr, "accepted invalid input: %s\n", inputs[i]);
+            failures++;
+        }
+
+        // Errors are sticky
+        expect(&json, STDI_JSON_ERROR, NULL);
+        close_input(&reader);
+    }
+}
+
+int main()
+{
+    // Fail instead of hanging if the tokenizer blocks on a live stream
+    alarm(10);
+
+    test_split_tokens();
+    test_large_tokens();
+    test_escapes();
+    test_depth_limit();
+    test_concatenated_documents();
+    test_errors();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
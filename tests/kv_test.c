@@ -0,0 +1,193 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stddef.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+typedef struct
+{
+    stdi_view_t level;
+    int64_t status;
+    bool cached;
+    stdi_view_t message_identifier;
+} record_t;
+
+static const stdi_kv_field_t fields[] = {
+    { "level", STDI_KV_VIEW, offsetof(record_t, level) },
+    { "status", STDI_KV_INT64, offsetof(record_t, status) },
+    { "cached", STDI_KV_BOOL, offsetof(record_t, cached) },
+    { "message_identifi", STDI_KV_VIEW, offsetof(record_t, message_identifier) }
+};
+
+/**
+ * @brief Parses a line into a zeroed record.
+ */
+static uint64_t parse(const stdi_kv_schema_t *schema, const char *line, record_t *record)
+{
+    memset(record, 0, sizeof(*record));
+    return stdi_kv_parse(schema, line, strlen(line), record);
+}
+
+/**
+ * @brief Checks that a view holds the given string.
+ */
+static bool view_equals(const stdi_view_t *view, const char *expected)
+{
+    return view->length == strlen(expected) && memcmp(view->data, expected, view->length) == 0;
+}
+
+/**
+ * @brief Values of every type land in their fields.
+ */
+static void test_fields(const stdi_kv_schema_t *schema)
+{
+    record_t record;
+    CHECK(parse(schema, "level=info status=-404 cached=true message_identifi=\"a b\"", &record) == 0xF);
+    CHECK(view_equals(&record.level, "info"));
+    CHECK(record.status == -404);
+    CHECK(record.cached);
+    CHECK(view_equals(&record.message_identifier, "a b"));
+
+    CHECK(parse(schema, "cached=0 status=+9223372036854775807", &record) == 0x6);
+    CHECK(!record.cached);
+    CHECK(record.status == INT64_MAX);
+}
+
+/**
+ * @brief Unknown keys and values that do not parse are skipped.
+ */
+static void test_skipped(const stdi_kv_schema_t *schema)
+{
+    record_t record;
+
+    // Unknown keys, including ones as long as an expected key
+    CHECK(parse(schema, "levels=x lever=x statuz=1 LEVEL=x level=warn", &record) == 0x1);
+    CHECK(view_equals(&record.level, "warn"));
+
+    // Values of the wrong type
+    CHECK(parse(schema, "status=12x cached=yes status=9223372036854775808", &record) == 0);
+    CHECK(record.status == 0 && !record.cached);
+}
+
+/**
+ * @brief An unknown key crafted to share an expected key's 64-bit hash is skipped.
+ */
+static void test_colliding_key(const stdi_kv_schema_t *schema)
+{
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    const char *target = fields[3].name;
+    uint64_t first;
+    uint64_t second;
+    memcpy(&first, target, sizeof(first));
+    memcpy(&second, target + 8, sizeof(second));
+
+    // Both 16-byte keys hash their first word into a state, then mix the second
+    // word into it, so matching the state after the second word is enough
+    uint64_t state = schema->seed ^ (16 * multiplier);
+    uint64_t target_state = (state ^ first) * multiplier;
+    target_state ^= target_state >> 32;
+
+    char key[17];
+    key[16] = '\0';
+    bool found = FALSE;
+
+    for (uint64_t attempt = 0; attempt < 1000 && !found; attempt++)
+    {
+        // Spell the attempt in lowercase letters for the first word
+        uint64_t counter = attempt;
+        for (size_t i = 0; i < 8; i++)
+        {
+            key[i] = (char) ('a' + counter % 26);
+            counter /= 26;
+        }
+
+        uint64_t word;
+        memcpy(&word, key, sizeof(word));
+        uint64_t key_state = (state ^ word) * multiplier;
+        key_state ^= key_state >> 32;
+
+        // Pick the second word that cancels the difference, if it stays one key
+        const uint64_t tail = second ^ target_state ^ key_state;
+        memcpy(key + 8, &tail, sizeof(tail));
+
+        found = TRUE;
+        for (size_t i = 8; i < 16; i++)
+        {
+            found = found && key[i] != '\0' && key[i] != '=' && key[i] != ' ' && key[i] != '\t';
+        }
+    }
+
+    CHECK(found);
+    if (!found)
+    {
+        return;
+    }
+
+    CHECK(stdi_hash(key, 16, schema->seed) == stdi_hash(target, 16, schema->seed));
+
+    char line[64];
+    snprintf(line, sizeof(line), "%s=forged", key);
+
+    record_t record;
+    CHECK(parse(schema, line, &record) == 0);
+    CHECK(record.message_identifier.data == NULL);
+}
+
+/**
+ * @brief Schemas with duplicate, missing or too many keys are rejected.
+ */
+static void test_invalid_schemas()
+{
+    stdi_kv_schema_t schema;
+    const stdi_kv_field_t duplicates[] = {
+        { "a", STDI_KV_VIEW, 0 },
+        { "b", STDI_KV_VIEW, 0 },
+        { "a", STDI_KV_INT64, 0 }
+    };
+
+    CHECK(!stdi_kv_schema_init(&schema, duplicates, 3));
+    CHECK(!stdi_kv_schema_init(&schema, duplicates, 0));
+    CHECK(!stdi_kv_schema_init(&schema, duplicates, 65));
+}
+
+int main()
+{
+    stdi_kv_schema_t schema;
+    CHECK(stdi_kv_schema_init(&schema, fields, sizeof(fields) / sizeof(fields[0])));
+
+    test_fields(&schema);
+    test_skipped(&schema);
+    test_colliding_key(&schema);
+    test_invalid_schemas();
+
+    stdi_kv_schema_destroy(&schema);
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
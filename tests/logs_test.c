@@ -0,0 +1,200 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Checks that a view holds the given string.
+ */
+static bool view_equals(const stdi_view_t view, const char *expected)
+{
+    return view.length == strlen(expected) && memcmp(view.data, expected, view.length) == 0;
+}
+
+/**
+ * @brief Checks the next logfmt pair.
+ */
+static void expect_pair(stdi_logfmt_t *iterator, const char *key, const char *value, const bool escaped)
+{
+    stdi_view_t actual_key;
+    stdi_view_t actual_value;
+    bool actual_escaped = !escaped;
+    CHECK(stdi_logfmt_next(iterator, &actual_key, &actual_value, &actual_escaped));
+    CHECK(view_equals(actual_key, key));
+    CHECK(view_equals(actual_value, value));
+    CHECK(actual_escaped == escaped);
+}
+
+/**
+ * @brief Bare, quoted, escaped and missing logfmt values.
+ */
+static void test_logfmt()
+{
+    const char *line = "level=info msg=\"hello \\\"world\\\"\" empty= flag\tpath=/a=b  quoted=\"\" last=\"unterminated";
+    stdi_logfmt_t iterator;
+    stdi_logfmt_init(&iterator, line, strlen(line));
+
+    expect_pair(&iterator, "level", "info", FALSE);
+    expect_pair(&iterator, "msg", "hello \\\"world\\\"", TRUE);
+    expect_pair(&iterator, "empty", "", FALSE);
+    expect_pair(&iterator, "flag", "", FALSE);
+    expect_pair(&iterator, "path", "/a=b", FALSE);
+    expect_pair(&iterator, "quoted", "", FALSE);
+    expect_pair(&iterator, "last", "unterminated", FALSE);
+
+    stdi_view_t key;
+    stdi_view_t value;
+    CHECK(!stdi_logfmt_next(&iterator, &key, &value, NULL));
+
+    // Blank lines hold no pairs
+    stdi_logfmt_init(&iterator, " \t ", 3);
+    CHECK(!stdi_logfmt_next(&iterator, &key, &value, NULL));
+}
+
+/**
+ * @brief Parses a syslog line, expecting success or failure.
+ */
+static bool parse_syslog(const char *line, stdi_syslog_t *syslog)
+{
+    return stdi_parse_syslog(line, strlen(line), syslog);
+}
+
+/**
+ * @brief RFC 5424 messages, with NILVALUEs in every optional field.
+ */
+static void test_syslog()
+{
+    stdi_syslog_t syslog;
+
+    CHECK(parse_syslog("<34>1 2003-10-11T22:14:15.003Z mymachine.example.com su - ID47 - 'su root' failed", &syslog));
+    CHECK(syslog.facility == 4 && syslog.severity == 2 && syslog.version == 1);
+    CHECK(view_equals(syslog.timestamp, "2003-10-11T22:14:15.003Z"));
+    CHECK(view_equals(syslog.hostname, "mymachine.example.com"));
+    CHECK(view_equals(syslog.app_name, "su"));
+    CHECK(syslog.proc_id.length == 0);
+    CHECK(view_equals(syslog.msg_id, "ID47"));
+    CHECK(syslog.structured_data.length == 0);
+    CHECK(view_equals(syslog.message, "'su root' failed"));
+
+    // Every header field and the structured data set to NILVALUE, without a message
+    CHECK(parse_syslog("<0>1 - - - - - -", &syslog));
+    CHECK(syslog.facility == 0 && syslog.severity == 0);
+    CHECK(syslog.timestamp.length == 0 && syslog.hostname.length == 0 && syslog.app_name.length == 0);
+    CHECK(syslog.proc_id.length == 0 && syslog.msg_id.length == 0 && syslog.structured_data.length == 0);
+    CHECK(syslog.message.length == 0);
+
+    // A dash that is part of a value is not a NILVALUE
+    CHECK(parse_syslog("<165>1 - host-1 -app 12 - - -x", &syslog));
+    CHECK(view_equals(syslog.hostname, "host-1"));
+    CHECK(view_equals(syslog.app_name, "-app"));
+    CHECK(view_equals(syslog.message, "-x"));
+
+    // Structured data with quoted and escaped brackets
+    CHECK(parse_syslog("<165>1 2003-10-11T22:14:15Z h a 1 m [id a=\"]\"][x b=\"\\\"]\\\"\"] msg", &syslog));
+    CHECK(view_equals(syslog.structured_data, "[id a=\"]\"][x b=\"\\\"]\\\"\"]"));
+    CHECK(view_equals(syslog.message, "msg"));
+
+    // Malformed messages
+    CHECK(!parse_syslog("", &syslog));
+    CHECK(!parse_syslog("34>1 - - - - - -", &syslog));
+    CHECK(!parse_syslog("<192>1 - - - - - -", &syslog));
+    CHECK(!parse_syslog("<>1 - - - - - -", &syslog));
+    CHECK(!parse_syslog("<34> - - - - - -", &syslog));
+    CHECK(!parse_syslog("<34>1 - - - - -", &syslog));
+    CHECK(!parse_syslog("<34>1 - -  - - -", &syslog));
+    CHECK(!parse_syslog("<34>1 - - - - - -x", &syslog));
+    CHECK(!parse_syslog("<34>1 - - - - - [id a=\"]\"", &syslog));
+    CHECK(!parse_syslog("<34>1 - - - - - x", &syslog));
+}
+
+/**
+ * @brief Parses an access log line, expecting success or failure.
+ */
+static bool parse_access_log(const char *line, stdi_access_log_t *log)
+{
+    return stdi_parse_access_log(line, strlen(line), log);
+}
+
+/**
+ * @brief Common and Combined Log Format lines, with escaped quotes in quoted fields.
+ */
+static void test_access_log()
+{
+    stdi_access_log_t log;
+
+    CHECK(parse_access_log("127.0.0.1 - frank [10/Oct/2000:13:55:36 -0700] \"GET /apache_pb.gif HTTP/1.0\" 200 2326", &log));
+    CHECK(view_equals(log.host, "127.0.0.1"));
+    CHECK(log.ident.length == 0);
+    CHECK(view_equals(log.user, "frank"));
+    CHECK(view_equals(log.time, "10/Oct/2000:13:55:36 -0700"));
+    CHECK(view_equals(log.request, "GET /apache_pb.gif HTTP/1.0"));
+    CHECK(view_equals(log.method, "GET") && view_equals(log.path, "/apache_pb.gif") && view_equals(log.protocol, "HTTP/1.0"));
+    CHECK(log.status == 200 && log.bytes == 2326);
+    CHECK(log.referer.length == 0 && log.user_agent.length == 0);
+
+    // Escaped quotes stay inside their field, unescaped
+    CHECK(parse_access_log(
+        "::1 - - [01/Jan/2024:00:00:00 +0000] \"GET /q?a=\\\"b\\\" HTTP/1.1\" 404 - \"-\" \"Agent \\\"X\\\" 1.0\"",
+        &log
+    ));
+    CHECK(view_equals(log.request, "GET /q?a=\\\"b\\\" HTTP/1.1"));
+    CHECK(view_equals(log.path, "/q?a=\\\"b\\\""));
+    CHECK(log.status == 404 && log.bytes == -1);
+    CHECK(log.referer.length == 0);
+    CHECK(view_equals(log.user_agent, "Agent \\\"X\\\" 1.0"));
+
+    // A request line that is not split into three parts
+    CHECK(parse_access_log("h - - [t] \"\\x16\\x03\" 400 0 \"http://a/\" \"\"", &log));
+    CHECK(view_equals(log.method, "\\x16\\x03") && log.path.length == 0 && log.protocol.length == 0);
+    CHECK(view_equals(log.referer, "http://a/") && log.user_agent.length == 0);
+
+    // Malformed lines
+    CHECK(!parse_access_log("", &log));
+    CHECK(!parse_access_log("h - - t] \"GET / HTTP/1.0\" 200 1", &log));
+    CHECK(!parse_access_log("h - - [t \"GET / HTTP/1.0\" 200 1", &log));
+    CHECK(!parse_access_log("h - - [t] GET / HTTP/1.0 200 1", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0 200 1", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\\\" 200 1", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 20 1", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 2x0 1", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 200", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 200 1k", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 200 1 \"-\"", &log));
+    CHECK(!parse_access_log("h - - [t] \"GET / HTTP/1.0\" 200 1 \"-\" \"agent", &log));
+}
+
+int main()
+{
+    test_logfmt();
+    test_syslog();
+    test_access_log();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
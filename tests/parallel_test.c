@@ -0,0 +1,245 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Writes a string to a file descriptor, failing the test on short writes.
+ */
+static void write_all(const int fd, const char *data)
+{
+    CHECK(write(fd, data, strlen(data)) == (ssize_t) strlen(data));
+}
+
+/**
+ * @brief Upper-cases a line, stopping at a line that reads "stop".
+ */
+static bool upper(const char *line, const size_t length, stdi_writer_t *output, void *context)
+{
+    (void) context;
+
+    if (length == 4 && memcmp(line, "stop", 4) == 0)
+    {
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        const char c = line[i] >= 'a' && line[i] <= 'z' ? (char) (line[i] - 'a' + 'A') : line[i];
+        stdi_writer_write(output, &c, 1);
+    }
+
+    stdi_writer_write(output, "\n", 1);
+    return TRUE;
+}
+
+/**
+ * @brief Checks that `expected` can be read from a descriptor within a few seconds.
+ */
+static void expect_output(const int fd, const char *expected)
+{
+    char buffer[256];
+    size_t total = 0;
+
+    while (total < strlen(expected))
+    {
+        struct pollfd descriptor = { fd, POLLIN, 0 };
+        if (poll(&descriptor, 1, 5000) != 1)
+        {
+            break;
+        }
+
+        const ssize_t bytes_read = read(fd, buffer + total, sizeof(buffer) - total);
+        if (bytes_read <= 0)
+        {
+            break;
+        }
+
+        total += (size_t) bytes_read;
+    }
+
+    CHECK(total == strlen(expected) && memcmp(buffer, expected, total) == 0);
+}
+
+/**
+ * @brief Lines of a slow producer come out while the producer is still running.
+ */
+static void test_slow_producer()
+{
+    int input[2];
+    int output[2];
+    CHECK(pipe(input) == 0 && pipe(output) == 0);
+
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(input[1]);
+        close(output[0]);
+
+        stdi_reader_t reader;
+        stdi_writer_t writer;
+        CHECK(stdi_reader_init(&reader, input[0], 0));
+        CHECK(stdi_writer_init(&writer, output[1], 0, STDI_FLUSH_BEFORE_READ));
+        stdi_reader_tie(&reader, &writer);
+
+        const bool result = stdi_parallel_map(&reader, &writer, upper, NULL, 4);
+        stdi_writer_destroy(&writer);
+        stdi_reader_destroy(&reader);
+        _exit(result && failures == 0 ? 0 : 1);
+    }
+
+    close(input[0]);
+    close(output[1]);
+
+    // The input stays open, so output must not wait for a full chunk or EOF
+    write_all(input[1], "a\n");
+    expect_output(output[0], "A\n");
+    write_all(input[1], "b\nc");
+    expect_output(output[0], "B\n");
+    write_all(input[1], "\nd\n");
+    expect_output(output[0], "C\nD\n");
+
+    close(input[1]);
+    expect_output(output[0], "");
+
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(output[0]);
+}
+
+/**
+ * @brief Runs stdi_parallel_map over a file, writing the output to another one.
+ *
+ * @return The result of stdi_parallel_map, the output is left in `output`.
+ */
+static bool map_file(FILE *input, FILE *output, const size_t threads)
+{
+    stdi_reader_t reader;
+    stdi_writer_t writer;
+    CHECK(stdi_reader_init(&reader, fileno(input), 0));
+    CHECK(stdi_writer_init(&writer, fileno(output), 0, STDI_FLUSH_EXPLICIT));
+
+    const bool result = stdi_parallel_map(&reader, &writer, upper, NULL, threads);
+    stdi_writer_destroy(&writer);
+    stdi_reader_destroy(&reader);
+
+    rewind(output);
+    return result;
+}
+
+/**
+ * @brief Many chunks, and lines longer than a chunk, come out in input order.
+ */
+static void test_order()
+{
+    FILE *input = tmpfile();
+    FILE *output = tmpfile();
+    CHECK(input != NULL && output != NULL);
+
+    // Put overlong lines at the start, in the middle and at the end
+    const size_t lines = 300000;
+    for (size_t i = 0; i < lines; i++)
+    {
+        if (i == 0 || i == lines / 2 || i + 1 == lines)
+        {
+            for (size_t j = 0; j < STDI_PARALLEL_CHUNK_SIZE * 3 / 2; j++)
+            {
+                fputc('x', input);
+            }
+        }
+
+        fprintf(input, "line %zu", i);
+        if (i + 1 < lines)
+        {
+            fputc('\n', input);
+        }
+    }
+
+    fflush(input);
+    rewind(input);
+    CHECK(map_file(input, output, 4));
+
+    // Every line comes out once and in order, the last one gains a newline
+    char expected[64];
+    size_t mismatches = 0;
+    int c;
+    for (size_t i = 0; i < lines; i++)
+    {
+        while ((c = fgetc(output)) == 'X')
+        {
+        }
+
+        snprintf(expected, sizeof(expected), "LINE %zu\n", i);
+        mismatches += c != expected[0];
+        for (size_t j = 1; j < strlen(expected); j++)
+        {
+            mismatches += fgetc(output) != expected[j];
+        }
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(fgetc(output) == EOF);
+
+    fclose(input);
+    fclose(output);
+}
+
+/**
+ * @brief A transform returning FALSE fails the map and discards later output.
+ */
+static void test_stop()
+{
+    FILE *input = tmpfile();
+    FILE *output = tmpfile();
+    CHECK(input != NULL && output != NULL);
+
+    fputs("a\nb\nstop\nc\n", input);
+    fflush(input);
+    rewind(input);
+    CHECK(!map_file(input, output, 3));
+
+    char buffer[16];
+    CHECK(fgets(buffer, sizeof(buffer), output) == NULL || strchr("AB", buffer[0]) != NULL);
+
+    fclose(input);
+    fclose(output);
+}
+
+int main()
+{
+    // Fail instead of hanging if the map blocks on a live stream
+    alarm(30);
+
+    test_slow_producer();
+    test_order();
+    test_stop();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
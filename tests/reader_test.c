@@ -0,0 +1,232 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+#define LINES "alpha\nbravo\ncharlie\ndelta\necho\nfoxtrot\n"
+
+/**
+ * @brief Returns a regular file holding the given bytes, positioned at the start.
+ */
+static int file_with(const char *data)
+{
+    FILE *file = tmpfile();
+    CHECK(file != NULL);
+    CHECK(fwrite(data, 1, strlen(data), file) == strlen(data));
+    fflush(file);
+
+    // Keep a descriptor of our own, the stream is leaked on purpose
+    const int fd = dup(fileno(file));
+    CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
+/**
+ * @brief Returns the read end of a pipe holding the given bytes.
+ */
+static int pipe_with(const char *data)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], data, strlen(data)) == (ssize_t) strlen(data));
+    close(fds[1]);
+    return fds[0];
+}
+
+/**
+ * @brief Reads the next line and compares it with the expected text and status.
+ */
+static void expect_line(stdi_reader_t *reader, const char *expected, const stdi_status_t expected_status)
+{
+    const char *line;
+    size_t length;
+    const stdi_status_t status = stdi_reader_read_line(reader, &line, &length);
+    CHECK(status == expected_status);
+    CHECK(line != NULL && length == strlen(expected) && memcmp(line, expected, length) == 0);
+}
+
+/**
+ * @brief A final line without a newline survives the buffer growing under it.
+ */
+static void test_final_partial_line(void)
+{
+    for (size_t capacity = 1; capacity <= 12; capacity++)
+    {
+        stdi_reader_t reader;
+        const int fd = pipe_with("ab\nabcdefg");
+        CHECK(stdi_reader_init(&reader, fd, capacity));
+        expect_line(&reader, "ab", STDI_STATUS_LINE);
+        expect_line(&reader, "abcdefg", STDI_STATUS_PARTIAL);
+
+        const char *line;
+        size_t length;
+        CHECK(stdi_reader_read_line(&reader, &line, &length) == STDI_STATUS_EOF);
+        CHECK(line == NULL && length == 0);
+        stdi_reader_destroy(&reader);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Resuming continues after the last consumed line, even with bytes still buffered.
+ */
+static void test_resume_buffered(void)
+{
+    stdi_reader_t reader;
+    const int fd = file_with(LINES);
+    CHECK(stdi_reader_init(&reader, fd, 8));
+    expect_line(&reader, "alpha", STDI_STATUS_LINE);
+    expect_line(&reader, "bravo", STDI_STATUS_LINE);
+
+    // The buffer holds bytes past the checkpoint
+    stdi_checkpoint_t checkpoint;
+    stdi_reader_checkpoint(&reader, &checkpoint);
+    CHECK(reader.end > reader.start);
+    CHECK(checkpoint.offset == 12);
+    CHECK(checkpoint.line == 2);
+    CHECK(checkpoint.line_start == 12);
+
+    // Read ahead, then go back
+    expect_line(&reader, "charlie", STDI_STATUS_LINE);
+    expect_line(&reader, "delta", STDI_STATUS_LINE);
+    CHECK(stdi_reader_resume(&reader, &checkpoint));
+    expect_line(&reader, "charlie", STDI_STATUS_LINE);
+
+    stdi_position_t position;
+    stdi_reader_position(&reader, &position);
+    CHECK(position.offset == 20);
+    CHECK(position.line == 4);
+    CHECK(position.column == 1);
+    stdi_reader_destroy(&reader);
+    close(fd);
+}
+
+/**
+ * @brief A checkpoint taken in the middle of a line restores the line and column.
+ */
+static void test_resume_mid_line(void)
+{
+    stdi_reader_t reader;
+    const int fd = file_with(LINES);
+    CHECK(stdi_reader_init(&reader, fd, 16));
+    expect_line(&reader, "alpha", STDI_STATUS_LINE);
+
+    // Consume part of "bravo"
+    char bytes[3];
+    CHECK(stdi_reader_read(&reader, bytes, sizeof(bytes)) == 3);
+    CHECK(memcmp(bytes, "bra", 3) == 0);
+
+    stdi_checkpoint_t checkpoint;
+    stdi_reader_checkpoint(&reader, &checkpoint);
+    CHECK(checkpoint.offset == 9);
+    CHECK(checkpoint.line == 1);
+    CHECK(checkpoint.line_start == 6);
+    stdi_reader_destroy(&reader);
+
+    // A fresh reader on the same file picks up where the old one stopped
+    CHECK(stdi_reader_init(&reader, fd, 16));
+    CHECK(stdi_reader_resume(&reader, &checkpoint));
+
+    stdi_position_t position;
+    stdi_reader_position(&reader, &position);
+    CHECK(position.offset == 9);
+    CHECK(position.line == 2);
+    CHECK(position.column == 4);
+
+    expect_line(&reader, "vo", STDI_STATUS_LINE);
+    expect_line(&reader, "charlie", STDI_STATUS_LINE);
+    CHECK(reader.line == 3);
+    stdi_reader_destroy(&reader);
+    close(fd);
+}
+
+/**
+ * @brief Resuming clears the end of input so the rest of the file is read again.
+ */
+static void test_resume_after_eof(void)
+{
+    stdi_reader_t reader;
+    const int fd = file_with("one\ntwo");
+    CHECK(stdi_reader_init(&reader, fd, 16));
+    expect_line(&reader, "one", STDI_STATUS_LINE);
+
+    stdi_checkpoint_t checkpoint;
+    stdi_reader_checkpoint(&reader, &checkpoint);
+    expect_line(&reader, "two", STDI_STATUS_PARTIAL);
+
+    const char *line;
+    size_t length;
+    CHECK(stdi_reader_read_line(&reader, &line, &length) == STDI_STATUS_EOF);
+
+    CHECK(stdi_reader_resume(&reader, &checkpoint));
+    expect_line(&reader, "two", STDI_STATUS_PARTIAL);
+    stdi_reader_destroy(&reader);
+    close(fd);
+}
+
+/**
+ * @brief Pipes and transcoded readers cannot be resumed and are left untouched.
+ */
+static void test_resume_unsupported(void)
+{
+    stdi_reader_t reader;
+    const int pipe_fd = pipe_with(LINES);
+    CHECK(stdi_reader_init(&reader, pipe_fd, 8));
+    expect_line(&reader, "alpha", STDI_STATUS_LINE);
+
+    stdi_checkpoint_t checkpoint;
+    stdi_reader_checkpoint(&reader, &checkpoint);
+    CHECK(!stdi_reader_resume(&reader, &checkpoint));
+    expect_line(&reader, "bravo", STDI_STATUS_LINE);
+    stdi_reader_destroy(&reader);
+    close(pipe_fd);
+
+    const int file_fd = file_with(LINES);
+    CHECK(stdi_reader_init(&reader, file_fd, 8));
+    CHECK(stdi_reader_set_encoding(&reader, STDI_ENCODING_LATIN1));
+    expect_line(&reader, "alpha", STDI_STATUS_LINE);
+    stdi_reader_checkpoint(&reader, &checkpoint);
+    CHECK(!stdi_reader_resume(&reader, &checkpoint));
+    expect_line(&reader, "bravo", STDI_STATUS_LINE);
+    stdi_reader_destroy(&reader);
+    close(file_fd);
+}
+
+int main(void)
+{
+    alarm(10);
+    test_final_partial_line();
+    test_resume_buffered();
+    test_resume_mid_line();
+    test_resume_after_eof();
+    test_resume_unsupported();
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+#define LINES 100000
+
+/**
+ * @brief Writes numbered lines into a ring in uneven chunks, then closes it.
+ *
+ * @return The number of lines written before the consumer abandoned the ring.
+ */
+static size_t produce(stdi_ring_t *ring, const size_t lines)
+{
+    char chunk[512];
+    size_t length = 0;
+
+    for (size_t i = 0; i < lines; i++)
+    {
+        length += (size_t) snprintf(chunk + length, sizeof(chunk) - length, "%zu\n", i);
+
+        // Flush every few lines, so writes straddle the end of the ring
+        if (length > 400 || i % 7 == 0 || i + 1 == lines)
+        {
+            if (!stdi_ring_write(ring, chunk, length))
+            {
+                return i;
+            }
+
+            length = 0;
+        }
+    }
+
+    stdi_ring_close(ring);
+    return lines;
+}
+
+/**
+ * @brief Checks that a reader returns increasing line numbers, and returns the last one.
+ */
+static long consume(stdi_reader_t *reader, long previous, const size_t limit)
+{
+    size_t length;
+    const char *line;
+
+    for (size_t i = 0; i < limit && (line = stdi_reader_next_line(reader, &length)) != NULL; i++)
+    {
+        const long value = strtol(line, NULL, 10);
+        if (value <= previous)
+        {
+            fprintf(stderr, "line %ld after %ld\n", value, previous);
+            failures++;
+        }
+
+        previous = value;
+    }
+
+    return previous;
+}
+
+/**
+ * @brief Runs `child` in a forked process that inherits the ring, and feeds it.
+ *
+ * @return The number of lines the producer managed to write.
+ */
+static size_t run(void (*child)(int fd), const size_t lines)
+{
+    int fd;
+    stdi_ring_t *ring = stdi_ring_create(4096, &fd);
+    CHECK(ring != NULL);
+    if (ring == NULL)
+    {
+        return 0;
+    }
+
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        failures = 0;
+        child(fd);
+        _exit(failures > 0);
+    }
+
+    const size_t written = produce(ring, lines);
+
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    stdi_ring_unmap(ring);
+    close(fd);
+    return written;
+}
+
+/**
+ * @brief Reads every line through a single reader.
+ */
+static void read_all(const int fd)
+{
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fd, 64) && reader.ring != NULL);
+    CHECK(consume(&reader, -1, LINES + 1) == LINES - 1);
+    CHECK(reader.line == LINES);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Reads through a second reader once the first one is destroyed.
+ *
+ * Whatever the first reader had buffered is lost, as it would be with a pipe,
+ * but the stream itself must not be abandoned.
+ */
+static void read_with_second_reader(const int fd)
+{
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fd, 64) && reader.ring != NULL);
+    consume(&reader, -1, 10);
+    stdi_reader_destroy(&reader);
+
+    // Skip the first line, it may be the tail of one the first reader buffered
+    size_t length;
+    CHECK(stdi_reader_init(&reader, fd, 64) && reader.ring != NULL);
+    CHECK(stdi_reader_next_line(&reader, &length) != NULL);
+    CHECK(consume(&reader, -1, LINES + 1) == LINES - 1);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Stops reading early and abandons the ring.
+ */
+static void read_and_abandon(const int fd)
+{
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fd, 64) && reader.ring != NULL);
+    consume(&reader, -1, 1);
+    stdi_ring_abandon(reader.ring);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Attaches through STDI_RING_ENV, which must then be hidden from children.
+ */
+static void read_through_environment(const int fd)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%d", fd);
+    setenv(STDI_RING_ENV, value, 1);
+
+    // Make sure stdin itself is not a ring
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    dup2(fds[0], STDIN_FILENO);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, STDIN_FILENO, 64) && reader.ring != NULL);
+    CHECK(getenv(STDI_RING_ENV) == NULL);
+    CHECK((fcntl(fd, F_GETFD) & FD_CLOEXEC) != 0);
+    CHECK(consume(&reader, -1, LINES + 1) == LINES - 1);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Reads a ring passed as stdin, which must stay inheritable.
+ */
+static void read_from_stdin(const int fd)
+{
+    CHECK(dup2(fd, STDIN_FILENO) == STDIN_FILENO);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, STDIN_FILENO, 64) && reader.ring != NULL);
+    CHECK((fcntl(STDIN_FILENO, F_GETFD) & FD_CLOEXEC) == 0);
+    CHECK(consume(&reader, -1, LINES + 1) == LINES - 1);
+    stdi_reader_destroy(&reader);
+}
+
+int main()
+{
+    // Fail instead of hanging on a lost wakeup
+    alarm(60);
+
+    // Other descriptors are not mistaken for rings
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(stdi_ring_open(fds[0]) == NULL);
+    close(fds[0]);
+    close(fds[1]);
+
+    CHECK(run(read_all, LINES) == LINES);
+    CHECK(run(read_with_second_reader, LINES) == LINES);
+    CHECK(run(read_and_abandon, LINES) < LINES);
+    CHECK(run(read_through_environment, LINES) == LINES);
+    CHECK(run(read_from_stdin, LINES) == LINES);
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
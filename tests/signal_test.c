@@ -0,0 +1,157 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <signal.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+static stdi_signal_reader_t handler_reader;
+static volatile sig_atomic_t handler_length = -1;
+
+/**
+ * @brief Returns the read end of a pipe holding the given bytes.
+ */
+static int pipe_with(const char *data, const size_t length)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], data, length) == (ssize_t) length);
+    close(fds[1]);
+    return fds[0];
+}
+
+/**
+ * @brief Reads a line from inside a signal handler.
+ */
+static void on_signal(const int signal_number)
+{
+    (void) signal_number;
+    size_t length;
+    bool complete;
+    if (stdi_signal_read_line(&handler_reader, &length, &complete) != NULL && complete)
+    {
+        handler_length = (sig_atomic_t) length;
+    }
+}
+
+/**
+ * @brief Lines, a final line without a newline, and the end of input.
+ */
+static void test_lines(void)
+{
+    stdi_signal_reader_t reader;
+    const int fd = pipe_with("one\n\nthree", 10);
+    stdi_signal_reader_init(&reader, fd);
+
+    size_t length;
+    bool complete;
+    const char *line = stdi_signal_read_line(&reader, &length, &complete);
+    CHECK(line != NULL && length == 3 && complete && memcmp(line, "one", 3) == 0);
+    line = stdi_signal_read_line(&reader, &length, &complete);
+    CHECK(line != NULL && length == 0 && complete);
+    line = stdi_signal_read_line(&reader, &length, &complete);
+    CHECK(line != NULL && length == 5 && complete && memcmp(line, "three", 5) == 0);
+    CHECK(stdi_signal_read_line(&reader, &length, &complete) == NULL);
+    CHECK(stdi_signal_read_line(&reader, &length, &complete) == NULL);
+    close(fd);
+}
+
+/**
+ * @brief Lines longer than the buffer are returned in pieces.
+ */
+static void test_long_line(void)
+{
+    static char data[STDI_SIGNAL_READER_BUFFER_SIZE * 2 + 11];
+    memset(data, 'x', sizeof(data) - 1);
+    data[sizeof(data) - 1] = '\n';
+
+    stdi_signal_reader_t reader;
+    const int fd = pipe_with(data, sizeof(data));
+    stdi_signal_reader_init(&reader, fd);
+
+    size_t total = 0;
+    size_t length;
+    bool complete = FALSE;
+    while (!complete)
+    {
+        const char *line = stdi_signal_read_line(&reader, &length, &complete);
+        CHECK(line != NULL);
+        if (line == NULL)
+        {
+            break;
+        }
+
+        CHECK(length <= STDI_SIGNAL_READER_BUFFER_SIZE);
+        total += length;
+    }
+
+    CHECK(total == sizeof(data) - 1);
+    CHECK(stdi_signal_read_line(&reader, &length, &complete) == NULL);
+    close(fd);
+}
+
+/**
+ * @brief Errors end the input and errno is left untouched.
+ */
+static void test_errno(void)
+{
+    stdi_signal_reader_t reader;
+    stdi_signal_reader_init(&reader, -1);
+
+    size_t length;
+    bool complete;
+    errno = ERANGE;
+    CHECK(stdi_signal_read_line(&reader, &length, &complete) == NULL);
+    CHECK(errno == ERANGE);
+}
+
+/**
+ * @brief The reader works from inside a signal handler.
+ */
+static void test_handler(void)
+{
+    const int fd = pipe_with("from handler\n", 13);
+    stdi_signal_reader_init(&handler_reader, fd);
+    signal(SIGUSR1, on_signal);
+    raise(SIGUSR1);
+    signal(SIGUSR1, SIG_DFL);
+    CHECK(handler_length == 12);
+    close(fd);
+}
+
+int main(void)
+{
+    alarm(10);
+    test_lines();
+    test_long_line();
+    test_errno();
+    test_handler();
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+typedef stdi_status_t (*read_function_t)(char **line, size_t *length);
+
+/**
+ * @brief Replaces stdin with a pipe holding the given bytes.
+ */
+static void set_stdin(const char *data, const size_t length)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], data, length) == (ssize_t) length);
+    close(fds[1]);
+
+    // The read end is already stdin if stdin was closed
+    if (fds[0] != STDIN_FILENO)
+    {
+        CHECK(dup2(fds[0], STDIN_FILENO) == STDIN_FILENO);
+        close(fds[0]);
+    }
+}
+
+/**
+ * @brief Checks the status and, when given, the contents of the next line.
+ */
+static void expect(const read_function_t read, const stdi_status_t status, const char *value, const size_t length)
+{
+    char *line;
+    size_t actual;
+    CHECK(read(&line, &actual) == status);
+
+    if (value != NULL)
+    {
+        CHECK(line != NULL && actual == length && memcmp(line, value, length) == 0 && line[length] == '\0');
+    }
+    else
+    {
+        CHECK(line == NULL);
+    }
+
+    free(line);
+}
+
+/**
+ * @brief Complete lines, a final partial line and the end of input are told apart.
+ */
+static void test_statuses(const read_function_t read)
+{
+    set_stdin("a\n\nx\0y\nlast", 11);
+    expect(read, STDI_STATUS_LINE, "a", 1);
+    expect(read, STDI_STATUS_LINE, "", 0);
+    expect(read, STDI_STATUS_LINE, "x\0y", 3);
+    expect(read, STDI_STATUS_PARTIAL, "last", 4);
+    expect(read, STDI_STATUS_EOF, NULL, 0);
+    expect(read, STDI_STATUS_EOF, NULL, 0);
+
+    // Input ending with a newline has no partial line
+    set_stdin("a\n", 2);
+    expect(read, STDI_STATUS_LINE, "a", 1);
+    expect(read, STDI_STATUS_EOF, NULL, 0);
+
+    set_stdin("", 0);
+    expect(read, STDI_STATUS_EOF, NULL, 0);
+}
+
+/**
+ * @brief Lines longer than the line and stdin buffers are returned whole.
+ */
+static void test_long_lines(const read_function_t read)
+{
+    const size_t length = STDI_STDIN_BUFFER_SIZE * 3 + STDI_READ_LINE_BUFFER_SIZE + 7;
+    char *input = malloc(length + 3);
+    CHECK(input != NULL);
+    memset(input, 'x', length);
+    memcpy(input + length, "\nb\n", 3);
+
+    // A pipe holds 64 KiB by default, which is enough for the whole input
+    set_stdin(input, length + 3);
+    expect(read, STDI_STATUS_LINE, input, length);
+    expect(read, STDI_STATUS_LINE, "b", 1);
+    expect(read, STDI_STATUS_EOF, NULL, 0);
+    free(input);
+}
+
+/**
+ * @brief Lines buffered by read_line are seen by every other stdin function.
+ */
+static void test_mixed_functions()
+{
+    set_stdin("one\ntwo\nthree\nfour\nfive\nsix", 27);
+    expect(read_line_status, STDI_STATUS_LINE, "one", 3);
+    CHECK(read_char() == 't');
+    expect(raw_read_line_status, STDI_STATUS_LINE, "wo", 2);
+    expect(read_line_status, STDI_STATUS_LINE, "three", 5);
+
+    // A reader over stdin takes over what read_line buffered
+    stdi_reader_t reader;
+    size_t length;
+    CHECK(stdi_reader_init(&reader, STDIN_FILENO, 4));
+    const char *line = stdi_reader_next_line(&reader, &length);
+    CHECK(line != NULL && length == 4 && memcmp(line, "four", 4) == 0);
+    line = stdi_reader_next_line(&reader, &length);
+    CHECK(line != NULL && length == 4 && memcmp(line, "five", 4) == 0);
+    line = stdi_reader_next_line(&reader, &length);
+    CHECK(line != NULL && length == 3 && memcmp(line, "six", 3) == 0);
+    CHECK(stdi_reader_next_line(&reader, &length) == NULL && reader.eof);
+    stdi_reader_destroy(&reader);
+
+    expect(read_line_status, STDI_STATUS_EOF, NULL, 0);
+}
+
+/**
+ * @brief Lines are returned as soon as they arrive on a live stream.
+ */
+static void test_live_stream()
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(dup2(fds[0], STDIN_FILENO) == STDIN_FILENO);
+    close(fds[0]);
+
+    // The pipe stays open, reading past the first line would hang
+    CHECK(write(fds[1], "a\nb\n", 4) == 4);
+    expect(read_line_status, STDI_STATUS_LINE, "a", 1);
+    expect(read_line_status, STDI_STATUS_LINE, "b", 1);
+    CHECK(write(fds[1], "c", 1) == 1);
+    close(fds[1]);
+    expect(read_line_status, STDI_STATUS_PARTIAL, "c", 1);
+}
+
+/**
+ * @brief Read errors are reported as such, and the legacy wrappers return NULL.
+ */
+static void test_errors()
+{
+    close(STDIN_FILENO);
+    expect(read_line_status, STDI_STATUS_ERROR, NULL, 0);
+    expect(raw_read_line_status, STDI_STATUS_ERROR, NULL, 0);
+    CHECK(read_line() == NULL);
+    CHECK(raw_read_line() == NULL);
+
+    // The end of input reads as an empty line through the legacy wrappers
+    set_stdin("", 0);
+    char *line = read_line();
+    CHECK(line != NULL && line[0] == '\0');
+    free(line);
+}
+
+int main()
+{
+    // Fail instead of hanging if a line read waits for more input
+    alarm(10);
+
+    test_statuses(read_line_status);
+    test_statuses(raw_read_line_status);
+    test_long_lines(read_line_status);
+    test_long_lines(raw_read_line_status);
+    test_mixed_functions();
+    test_live_stream();
+    test_errors();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+#define SECOND 1000000000LL
+
+/**
+ * @brief Checks that a timestamp parses to the given value and length.
+ */
+static void expect(const char *input, const int64_t expected, const size_t expected_consumed)
+{
+    int64_t nanoseconds = 0;
+    size_t consumed = 0;
+    const bool parsed = stdi_parse_timestamp(input, strlen(input), &nanoseconds, &consumed);
+
+    if (!parsed || nanoseconds != expected || consumed != expected_consumed)
+    {
+        fprintf(stderr, "%s: got %d, %lld, %zu\n", input, parsed, (long long) nanoseconds, consumed);
+        failures++;
+    }
+}
+
+/**
+ * @brief Checks that a timestamp is rejected.
+ */
+static void reject(const char *input)
+{
+    int64_t nanoseconds;
+    if (stdi_parse_timestamp(input, strlen(input), &nanoseconds, NULL))
+    {
+        fprintf(stderr, "accepted invalid timestamp: %s\n", input);
+        failures++;
+    }
+}
+
+/**
+ * @brief Separators, offsets and the epoch boundaries.
+ */
+static void test_valid()
+{
+    expect("1970-01-01T00:00:00Z", 0, 20);
+    expect("1970-01-01T00:00:00", 0, 19);
+    expect("1970-01-01t00:00:00z", 0, 20);
+    expect("1970-01-01 00:00:01", SECOND, 19);
+    expect("2000-02-29T12:34:56+02:00", 951820496 * SECOND, 25);
+    expect("2020-01-01T00:00:00+0530", 1577817000 * SECOND, 24);
+    expect("1999-12-31T16:00:00-08:00", 946684800 * SECOND, 25);
+    expect("1969-12-31T23:59:59Z", -SECOND, 20);
+
+    // Leap seconds are accepted and counted like the next second
+    expect("2016-12-31T23:59:60Z", (1483228799 + 1) * SECOND, 20);
+
+    // Trailing bytes are left for the caller
+    expect("2020-01-01T05:30:00+05:30 GET /", 1577836800 * SECOND, 25);
+    expect("2020-01-01T00:00:00Zabc", 1577836800 * SECOND, 20);
+}
+
+/**
+ * @brief Fractions of any length, truncated to nanoseconds.
+ */
+static void test_fractions()
+{
+    expect("1970-01-01T00:00:00.5Z", 500000000, 22);
+    expect("1970-01-01T00:00:00.000000001Z", 1, 30);
+    expect("1970-01-01T00:00:00.123456789999Z", 123456789, 33);
+    expect("1970-01-01T00:00:01.25+00:00", SECOND + 250000000, 28);
+    expect("1969-12-31T23:59:59.5Z", -500000000, 22);
+    reject("1970-01-01T00:00:00.Z");
+    reject("1970-01-01T00:00:00.");
+}
+
+/**
+ * @brief Invalid dates, times, offsets and shapes are rejected.
+ */
+static void test_invalid()
+{
+    // Days past the end of the month, including non-leap years
+    reject("2001-02-29T00:00:00Z");
+    reject("1900-02-29T00:00:00Z");
+    reject("2000-02-30T00:00:00Z");
+    reject("2000-04-31T00:00:00Z");
+    reject("2000-00-10T00:00:00Z");
+    reject("2000-13-01T00:00:00Z");
+    reject("2000-01-00T00:00:00Z");
+    reject("2000-01-32T00:00:00Z");
+
+    // Times out of range
+    reject("2000-01-01T24:00:00Z");
+    reject("2000-01-01T00:60:00Z");
+    reject("2000-01-01T00:00:61Z");
+
+    // Offsets out of range or truncated
+    reject("2000-01-01T00:00:00+24:00");
+    reject("2000-01-01T00:00:00+05:60");
+    reject("2000-01-01T00:00:00+05");
+    reject("2000-01-01T00:00:00+5:30");
+
+    // Malformed shapes
+    reject("");
+    reject("2000-01-01T00:00:0");
+    reject("2000-01-01X00:00:00Z");
+    reject("2000/01/01T00:00:00Z");
+    reject("20a0-01-01T00:00:00Z");
+    reject("2000-01-01T00-00:00Z");
+    reject("2000-01-01T00:00:0aZ");
+
+    // Outside of what 64-bit nanoseconds can hold
+    reject("2263-01-01T00:00:00Z");
+    reject("1600-01-01T00:00:00Z");
+}
+
+int main()
+{
+    test_valid();
+    test_fractions();
+    test_invalid();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
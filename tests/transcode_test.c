@@ -0,0 +1,257 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+#define COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+// "Aé€😀\nz" as UTF-16 code units and as the expected lines
+static const uint16_t text[] = { 0x41, 0xE9, 0x20AC, 0xD83D, 0xDE00, 0x0A, 0x7A };
+static const char *text_lines = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\nz\n";
+
+/**
+ * @brief Serializes code units as UTF-16, optionally after a byte order mark.
+ *
+ * @return The number of bytes written.
+ */
+static size_t to_utf16(const uint16_t *units, const size_t count, const bool big_endian, const bool bom, char *output)
+{
+    size_t written = 0;
+    for (size_t i = 0; i < count + bom; i++)
+    {
+        const uint16_t unit = bom && i == 0 ? 0xFEFF : units[i - bom];
+        output[written++] = (char) (big_endian ? unit >> 8 : unit & 0xFF);
+        output[written++] = (char) (big_endian ? unit & 0xFF : unit >> 8);
+    }
+
+    return written;
+}
+
+/**
+ * @brief Reads every line of a reader, each followed by a newline.
+ */
+static void read_lines(stdi_reader_t *reader, char *output, const size_t capacity)
+{
+    size_t written = 0;
+    size_t length;
+    const char *line;
+
+    while ((line = stdi_reader_next_line(reader, &length)) != NULL && written + length + 1 < capacity)
+    {
+        memcpy(output + written, line, length);
+        written += length;
+        output[written++] = '\n';
+    }
+
+    output[written] = '\0';
+    CHECK(!reader->error);
+}
+
+/**
+ * @brief Transcodes bytes fed through a closed pipe and compares the lines.
+ */
+static void expect(
+    const char *input,
+    const size_t length,
+    const stdi_encoding_t encoding,
+    const size_t capacity,
+    const char *expected
+)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], input, length) == (ssize_t) length);
+    close(fds[1]);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fds[0], capacity));
+    CHECK(stdi_reader_set_encoding(&reader, encoding));
+
+    char output[256];
+    read_lines(&reader, output, sizeof(output));
+    if (strcmp(output, expected) != 0)
+    {
+        fprintf(stderr, "encoding %d, capacity %zu: got \"%s\"\n", encoding, capacity, output);
+        failures++;
+    }
+
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+}
+
+/**
+ * @brief Both byte orders, with and without a BOM, at every small buffer size.
+ */
+static void test_capacities()
+{
+    char input[64];
+    for (size_t capacity = 4; capacity <= 40; capacity++)
+    {
+        for (int variant = 0; variant < 4; variant++)
+        {
+            const bool big_endian = variant & 1;
+            const size_t length = to_utf16(text, COUNT(text), big_endian, variant & 2, input);
+            expect(input, length, big_endian ? STDI_ENCODING_UTF16BE : STDI_ENCODING_UTF16LE, capacity, text_lines);
+        }
+    }
+}
+
+/**
+ * @brief Surrogate pairs and byte order marks split across reads of a live stream.
+ */
+static void test_split_reads()
+{
+    char input[64];
+    const size_t length = to_utf16(text, COUNT(text), FALSE, TRUE, input);
+
+    // Split once inside the BOM and once at every byte of the surrogate pair
+    for (size_t split = 7; split <= 11; split++)
+    {
+        int fds[2];
+        CHECK(pipe(fds) == 0);
+
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            // Deliver the bytes in three reads
+            close(fds[0]);
+            const size_t parts[4] = { 0, 1, split, length };
+            for (size_t i = 0; i < 3; i++)
+            {
+                CHECK(write(fds[1], input + parts[i], parts[i + 1] - parts[i]) == (ssize_t) (parts[i + 1] - parts[i]));
+                usleep(20000);
+            }
+
+            _exit(failures > 0);
+        }
+
+        close(fds[1]);
+
+        stdi_reader_t reader;
+        CHECK(stdi_reader_init(&reader, fds[0], 8));
+        CHECK(stdi_reader_set_encoding(&reader, STDI_ENCODING_UTF16LE));
+
+        char output[256];
+        read_lines(&reader, output, sizeof(output));
+        CHECK(strcmp(output, text_lines) == 0);
+
+        int status;
+        CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        close(fds[0]);
+        stdi_reader_destroy(&reader);
+    }
+}
+
+/**
+ * @brief Unpaired surrogates and dangling bytes become U+FFFD.
+ */
+static void test_invalid_sequences()
+{
+    static const uint16_t high_then_letter[] = { 0xD83D, 0x41 };
+    static const uint16_t lone_low[] = { 0xDE00, 0x41 };
+    static const uint16_t high_twice[] = { 0xD83D, 0xD83D, 0xDE00 };
+    static const uint16_t high_at_end[] = { 0x41, 0xD83D };
+    char input[64];
+    size_t length;
+
+    length = to_utf16(high_then_letter, COUNT(high_then_letter), FALSE, FALSE, input);
+    expect(input, length, STDI_ENCODING_UTF16LE, 0, "\xEF\xBF\xBD" "A\n");
+
+    length = to_utf16(lone_low, COUNT(lone_low), TRUE, FALSE, input);
+    expect(input, length, STDI_ENCODING_UTF16BE, 0, "\xEF\xBF\xBD" "A\n");
+
+    length = to_utf16(high_twice, COUNT(high_twice), FALSE, FALSE, input);
+    expect(input, length, STDI_ENCODING_UTF16LE, 0, "\xEF\xBF\xBD\xF0\x9F\x98\x80\n");
+
+    length = to_utf16(high_at_end, COUNT(high_at_end), FALSE, FALSE, input);
+    expect(input, length, STDI_ENCODING_UTF16LE, 0, "A\xEF\xBF\xBD\n");
+
+    // An odd number of bytes leaves half a code unit
+    expect("A\0B", 3, STDI_ENCODING_UTF16LE, 0, "A\xEF\xBF\xBD\n");
+
+    // A byte order mark is only skipped at the start
+    length = to_utf16(text, 1, FALSE, TRUE, input);
+    length += to_utf16(text, 1, FALSE, TRUE, input + length);
+    expect(input, length, STDI_ENCODING_UTF16LE, 0, "A\xEF\xBB\xBF" "A\n");
+}
+
+/**
+ * @brief Latin-1 bytes map to the code points of the same value.
+ */
+static void test_latin1()
+{
+    expect("caf\xE9\n\xFF\xA0x", 8, STDI_ENCODING_LATIN1, 4, "caf\xC3\xA9\n\xC3\xBF\xC2\xA0x\n");
+
+    // A Latin-1 source has no byte order mark to skip
+    expect("\xFF\xFE", 2, STDI_ENCODING_LATIN1, 0, "\xC3\xBF\xC3\xBE\n");
+}
+
+/**
+ * @brief Bytes buffered by format detection are transcoded once the encoding is set.
+ */
+static void test_after_detection()
+{
+    char input[64];
+    const size_t length = to_utf16(text, COUNT(text), TRUE, TRUE, input);
+
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], input, length) == (ssize_t) length);
+    close(fds[1]);
+
+    stdi_reader_t reader;
+    CHECK(stdi_reader_init(&reader, fds[0], 0));
+    CHECK(stdi_detect_format(&reader) == STDI_FORMAT_UTF16BE);
+    CHECK(stdi_reader_set_encoding(&reader, STDI_ENCODING_UTF16BE));
+
+    // The encoding can only be set once
+    CHECK(!stdi_reader_set_encoding(&reader, STDI_ENCODING_LATIN1));
+
+    char output[256];
+    read_lines(&reader, output, sizeof(output));
+    CHECK(strcmp(output, text_lines) == 0);
+
+    close(fds[0]);
+    stdi_reader_destroy(&reader);
+}
+
+int main()
+{
+    // Fail instead of hanging if transcoding waits for input that is already staged
+    alarm(10);
+
+    test_capacities();
+    test_split_reads();
+    test_invalid_sequences();
+    test_latin1();
+    test_after_detection();
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+* This code is distributed under the terms of the GNU General Public License.
+ * For more information, please refer to the LICENSE file in the root directory.
+ * -------------------------------------------------
+ * Copyright (C) 2025 Rodrigo R.
+ * This program comes with ABSOLUTELY NO WARRANTY; for details type `show w'.
+ * This is free software, and you are welcome to redistribute it
+ * under certain conditions; type `show c' for details.
+*/
+
+#include "../stdi.h"
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+/**
+ * @brief Creates a pipe whose read end never blocks.
+ */
+static void open_pipe(int fds[2])
+{
+    CHECK(pipe(fds) == 0);
+    CHECK(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+}
+
+/**
+ * @brief Checks that exactly the expected bytes are waiting in a pipe.
+ */
+static void expect_output(const int fd, const char *expected, const size_t length)
+{
+    static char output[1 << 16];
+    size_t total = 0;
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, output + total, sizeof(output) - total)) > 0)
+    {
+        total += (size_t) bytes_read;
+    }
+
+    CHECK(total == length);
+    CHECK(memcmp(output, expected, length) == 0);
+}
+
+/**
+ * @brief Small writes stay buffered until a flush or a full buffer.
+ */
+static void test_buffering(void)
+{
+    int fds[2];
+    open_pipe(fds);
+
+    stdi_writer_t writer;
+    CHECK(stdi_writer_init(&writer, fds[1], 16, STDI_FLUSH_EXPLICIT));
+    CHECK(stdi_writer_write(&writer, "abc", 3));
+    CHECK(stdi_writer_write_line(&writer, "de", 2));
+    CHECK(writer.length == 6);
+    expect_output(fds[0], "", 0);
+
+    CHECK(stdi_writer_flush(&writer));
+    CHECK(writer.length == 0);
+    expect_output(fds[0], "abcde\n", 6);
+
+    // A small payload that does not fit flushes the pending bytes first
+    CHECK(stdi_writer_write(&writer, "0123456789", 10));
+    CHECK(stdi_writer_write(&writer, "abcdefg", 7));
+    expect_output(fds[0], "0123456789", 10);
+    CHECK(writer.length == 7);
+
+    // Destroying flushes the rest
+    CHECK(stdi_writer_destroy(&writer));
+    CHECK(writer.buffer == NULL);
+    expect_output(fds[0], "abcdefg", 7);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief Large payloads are written right away, after the pending bytes and before their suffix.
+ */
+static void test_large_writes(void)
+{
+    int fds[2];
+    open_pipe(fds);
+
+    char large[1000];
+    for (size_t i = 0; i < sizeof(large); i++)
+    {
+        large[i] = (char) ('a' + i % 26);
+    }
+
+    stdi_writer_t writer;
+    CHECK(stdi_writer_init(&writer, fds[1], 64, STDI_FLUSH_EXPLICIT));
+    CHECK(stdi_writer_write(&writer, "head ", 5));
+    CHECK(stdi_writer_write_line(&writer, large, sizeof(large)));
+    CHECK(writer.length == 0);
+
+    char expected[5 + sizeof(large) + 1];
+    memcpy(expected, "head ", 5);
+    memcpy(expected + 5, large, sizeof(large));
+    expected[sizeof(expected) - 1] = '\n';
+    expect_output(fds[0], expected, sizeof(expected));
+
+    // Without a suffix
+    CHECK(stdi_writer_write(&writer, large, 40));
+    CHECK(writer.length == 40);
+    CHECK(stdi_writer_write(&writer, large + 40, 40));
+    CHECK(writer.length == 0);
+    expect_output(fds[0], large, 80);
+
+    CHECK(stdi_writer_destroy(&writer));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief A writer over fd -1 keeps everything in memory.
+ */
+static void test_memory_writer(void)
+{
+    stdi_writer_t writer;
+    CHECK(stdi_writer_init(&writer, -1, 4, STDI_FLUSH_EXPLICIT));
+
+    char expected[3000];
+    size_t length = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        char line[16];
+        const int size = snprintf(line, sizeof(line), "line %d", i);
+        CHECK(stdi_writer_write_line(&writer, line, (size_t) size));
+        memcpy(expected + length, line, (size_t) size);
+        length += (size_t) size;
+        expected[length++] = '\n';
+    }
+
+    CHECK(stdi_writer_flush(&writer));
+    CHECK(writer.length == length);
+    CHECK(writer.capacity >= length);
+    CHECK(memcmp(writer.buffer, expected, length) == 0);
+    CHECK(!writer.error);
+    CHECK(stdi_writer_destroy(&writer));
+}
+
+/**
+ * @brief A failed write sets the error flag and is reported by every call that writes.
+ */
+static void test_errors(void)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    close(fds[0]);
+
+    stdi_writer_t writer;
+    CHECK(stdi_writer_init(&writer, fds[1], 16, STDI_FLUSH_EXPLICIT));
+    CHECK(stdi_writer_write(&writer, "abc", 3));
+    CHECK(!writer.error);
+    CHECK(!stdi_writer_flush(&writer));
+    CHECK(writer.error);
+
+    // Large payloads fail the same way
+    writer.error = FALSE;
+    CHECK(!stdi_writer_write(&writer, "0123456789abcdef0123", 20));
+    CHECK(writer.error);
+
+    writer.error = FALSE;
+    CHECK(stdi_writer_write(&writer, "abc", 3));
+    CHECK(!stdi_writer_destroy(&writer));
+    CHECK(writer.error);
+    close(fds[1]);
+}
+
+/**
+ * @brief Reads a line from a pipe whose data only arrives after a delay.
+ *
+ * The first line is available right away, the second one is written by a
+ * child process once the reader had to wait. Returns whether the pending
+ * output reached the output pipe before the reader started waiting.
+ */
+static bool flushed_before_wait(const stdi_flush_policy_t policy)
+{
+    int input[2];
+    int output[2];
+    CHECK(pipe(input) == 0);
+    open_pipe(output);
+    CHECK(write(input[1], "a\n", 2) == 2);
+
+    stdi_reader_t reader;
+    stdi_writer_t writer;
+    CHECK(stdi_reader_init(&reader, input[0], 64));
+    CHECK(stdi_writer_init(&writer, output[1], 64, policy));
+    stdi_reader_tie(&reader, &writer);
+
+    // Input is available, so nothing is flushed
+    const char *line;
+    size_t length;
+    CHECK(stdi_writer_write_line(&writer, "prompt", 6));
+    CHECK(stdi_reader_read_line(&reader, &line, &length) == STDI_STATUS_LINE);
+    expect_output(output[0], "", 0);
+
+    // The child reports whether the output was there when it woke up
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        usleep(200 * 1000);
+        char buffer[8];
+        const bool flushed = read(output[0], buffer, sizeof(buffer)) == 7;
+        CHECK(write(input[1], "b\n", 2) == 2);
+        _exit(flushed ? 0 : 1);
+    }
+
+    close(input[1]);
+    CHECK(stdi_reader_read_line(&reader, &line, &length) == STDI_STATUS_LINE);
+    CHECK(length == 1 && line[0] == 'b');
+
+    int status;
+    CHECK(waitpid(child, &status, 0) == child);
+
+    stdi_writer_destroy(&writer);
+    stdi_reader_destroy(&reader);
+    close(input[0]);
+    close(output[0]);
+    close(output[1]);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * @brief Only STDI_FLUSH_BEFORE_READ flushes a tied writer before the reader blocks.
+ */
+static void test_tie(void)
+{
+    CHECK(flushed_before_wait(STDI_FLUSH_BEFORE_READ));
+    CHECK(!flushed_before_wait(STDI_FLUSH_EXPLICIT));
+}
+
+int main(void)
+{
+    alarm(10);
+    signal(SIGPIPE, SIG_IGN);
+    test_buffering();
+    test_large_writes();
+    test_memory_writer();
+    test_errors();
+    test_tie();
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}